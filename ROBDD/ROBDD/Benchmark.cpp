@@ -0,0 +1,264 @@
+#include "Benchmark.h"
+#include "ROBDD.h"
+#include "Parallel.h"
+#include "Explicit.h"
+#include "Formula.h"
+#include "Parser.h"
+#include "Models.h"
+#include <chrono>
+#include <cstdlib>
+#include <unordered_map>
+
+static double Milliseconds(chrono::steady_clock::time_point start)
+{
+	return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+void BenchmarkThreads(int nodes, int max_threads, ostream& out)
+{
+	Model model;
+	RandomModel(nodes, 3, 1, model);
+	Graph& G = model.G;
+	InterleaveOrder(G.Depth());
+	ROBDD p, q;
+	p.FromTrueValueVector(model.labels[0], G.Depth());
+	q.FromTrueValueVector(model.labels[1], G.Depth());
+	TransitionRelation R; //built outside the timings
+	R.FromGraph(G, PartitionThreshold());
+	Manager().Reorder();
+	Manager().SetAutoReorder(false); //every run sees the same variable order
+	ROBDD eg, eu;
+	double base_eg = 0, base_eu = 0;
+	out << "threads\tEG ms\tEU ms\tEG speedup\tEU speedup\n";
+	for (int threads = 1; threads <= max_threads; threads *= 2)
+	{
+		SetWorkers(threads);
+		Manager().CollectGarbage();
+		Manager().SetCacheSize(Manager().CacheSize()); //every run starts with a cold cache
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		ROBDD eg_result = EG(R, p);
+		double eg_time = Milliseconds(start);
+		Manager().SetCacheSize(Manager().CacheSize());
+		start = chrono::steady_clock::now();
+		ROBDD eu_result = EU(R, p, q);
+		double eu_time = Milliseconds(start);
+		if (threads == 1)
+		{
+			base_eg = eg_time;
+			base_eu = eu_time;
+			eg = eg_result;
+			eu = eu_result;
+		}
+		else if (eg_result.root != eg.root || eu_result.root != eu.root) out << "results differ from the single-threaded run\n";
+		out << threads << '\t' << eg_time << '\t' << eu_time << '\t' << base_eg / eg_time << '\t' << base_eu / eu_time << '\n';
+		if (threads < max_threads && threads * 2 > max_threads) threads = max_threads / 2; //always finish with max_threads
+	}
+	SetWorkers(1);
+}
+
+void BenchmarkEngines(int nodes, ostream& out)
+{
+	Model model;
+	RandomModel(nodes, 3, 1, model);
+	Graph& G = model.G;
+	G.IndexPredecessors();
+	InterleaveOrder(G.Depth());
+	ROBDD p, q;
+	p.FromTrueValueVector(model.labels[0], G.Depth());
+	q.FromTrueValueVector(model.labels[1], G.Depth());
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	TransitionRelation R;
+	R.FromGraph(G, PartitionThreshold());
+	ROBDD ex = EX(R, p); //includes building the transition relation
+	double symbolic[3] = { Milliseconds(start) };
+	start = chrono::steady_clock::now();
+	ROBDD eg = EG(R, p);
+	symbolic[1] = Milliseconds(start);
+	start = chrono::steady_clock::now();
+	ROBDD eu = EU(R, p, q);
+	symbolic[2] = Milliseconds(start);
+	start = chrono::steady_clock::now();
+	StateSet p_set = ToStateSet(p, G.num_nodes, G.Depth()), q_set = ToStateSet(q, G.num_nodes, G.Depth());
+	double convert = Milliseconds(start);
+	start = chrono::steady_clock::now();
+	StateSet ex_set = EX(G, p_set);
+	double explicit_ms[3] = { Milliseconds(start) };
+	start = chrono::steady_clock::now();
+	StateSet eg_set = EG(G, p_set);
+	explicit_ms[1] = Milliseconds(start);
+	start = chrono::steady_clock::now();
+	StateSet eu_set = EU(G, p_set, q_set);
+	explicit_ms[2] = Milliseconds(start);
+	ROBDD real; //the symbolic engine also answers for encodings past the last node
+	real.FromRange(0, G.num_nodes - 1, G.Depth());
+	if (ToROBDD(ex_set, G.Depth()).root != AND(ex, real).root || ToROBDD(eg_set, G.Depth()).root != AND(eg, real).root || ToROBDD(eu_set, G.Depth()).root != AND(eu, real).root) out << "engines disagree\n";
+	out << "engine\tEX ms\tEG ms\tEU ms\n";
+	out << "symbolic\t" << symbolic[0] << '\t' << symbolic[1] << '\t' << symbolic[2] << '\n';
+	out << "explicit\t" << explicit_ms[0] << '\t' << explicit_ms[1] << '\t' << explicit_ms[2] << '\n';
+	out << "converting the propositions to bitsets took " << convert << " ms\n";
+}
+
+static ROBDD Variable(int var)
+{
+	vector<signed char> cube(var + 1, -1);
+	cube[var] = 1;
+	ROBDD ret;
+	ret.FromCubes(vector<vector<signed char> >(1, cube));
+	return ret;
+}
+
+void BenchmarkReorder(int bits, ostream& out)
+{
+	vector<int> order; //every current-state bit above every next-state bit, the relation of a counter is exponential in that order
+	for (int i = bits - 1; i >= 0; i--) order.push_back(i);
+	for (int i = bits; i < bits * 2; i++) order.push_back(i);
+	ROBDD reference;
+	out << "auto reorder\tms\tpeak live nodes\treorderings\trelation nodes\n";
+	for (int reorder = 0; reorder <= 1; reorder++)
+	{
+		Manager().SetAutoReorder(false);
+		Manager().CollectGarbage();
+		Manager().SetOrder(order);
+		Manager().SetCacheSize(Manager().CacheSize());
+		Manager().ResetPeakNodes();
+		Manager().SetAutoReorder(reorder != 0);
+		size_t reorder_runs = Manager().ReorderRuns();
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		vector<ROBDD> conjuncts; //x_(bits+i) is x_i flipped when every less significant bit is set, x_0 being the most significant
+		ROBDD carry;
+		carry.FromConstant(1);
+		for (int i = bits - 1; i >= 0; i--)
+		{
+			ROBDD x = Variable(i), flipped = ITE(carry, NOT(x), x);
+			conjuncts.push_back(ITE(Variable(bits + i), flipped, NOT(flipped)));
+			carry = AND(carry, x);
+		}
+		TransitionRelation R;
+		R.FromConjuncts(conjuncts, bits, 0); //one monolithic cluster, the conjunction is where the order matters
+		ROBDD states = Variable(bits - 1); //odd
+		for (int i = 0; i < bits; i++) states = EX(R, states);
+		double ms = Milliseconds(start);
+		if (reorder == 0) reference = states;
+		else if (states.root != reference.root) out << "results differ with reordering\n";
+		out << (reorder ? "on" : "off") << '\t' << ms << '\t' << Manager().PeakNodes() << '\t' << Manager().ReorderRuns() - reorder_runs << '\t' << R.blocks[0][0].relation.NodeCount() << '\n';
+	}
+	Manager().SetAutoReorder(false);
+}
+
+static string Quote(const string& text) //as a JSON string
+{
+	string ret = "\"";
+	for (int i = 0; i < text.size(); i++)
+	{
+		if (text[i] == '"' || text[i] == '\\') ret += '\\';
+		ret += text[i];
+	}
+	return ret + "\"";
+}
+
+static double ApplyMilliseconds(const vector<ROBDD>& propositions, int engine, int num_states, int depth) //AND and OR of every pair of propositions and their negations
+{
+	vector<ROBDD> operands;
+	vector<StateSet> sets;
+	for (int i = 0; i < propositions.size(); i++)
+	{
+		operands.push_back(propositions[i]);
+		operands.push_back(NOT(propositions[i]));
+	}
+	for (int i = 0; i < operands.size() && engine == ENGINE_EXPLICIT; i++) sets.push_back(ToStateSet(operands[i], num_states, depth));
+	Manager().SetCacheSize(Manager().CacheSize());
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	for (int i = 0; i < operands.size(); i++)
+	{
+		for (int j = 0; j < operands.size(); j++)
+		{
+			if (engine == ENGINE_EXPLICIT)
+			{
+				AND(sets[i], sets[j]);
+				OR(sets[i], sets[j]);
+			}
+			else
+			{
+				AND(operands[i], operands[j]);
+				OR(operands[i], operands[j]);
+			}
+		}
+	}
+	return Milliseconds(start);
+}
+
+static void RunModel(Model& model, int engine, ostream& out) //one JSON record
+{
+	Manager().CollectGarbage();
+	vector<int> order;
+	for (int i = 0; i < Manager().NumVars(); i++) order.push_back(i);
+	Manager().SetOrder(order); //every run starts from the same order
+	InterleaveOrder(model.G.Depth());
+	Manager().SetCacheSize(Manager().CacheSize());
+	Manager().ResetPeakNodes();
+	size_t allocated = Manager().NodesAllocated(), gc_runs = Manager().GCRuns(), reorder_runs = Manager().ReorderRuns();
+	size_t hits = Manager().CacheHits(), misses = Manager().CacheMisses();
+	Graph& G = model.G;
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	vector<ROBDD> propositions(model.labels.size());
+	for (int i = 0; i < model.labels.size(); i++) propositions[i].FromTrueValueVector(model.labels[i], G.Depth());
+	double encode_ms = Milliseconds(start);
+	double apply_ms = ApplyMilliseconds(propositions, engine, G.num_nodes, G.Depth());
+	if (engine == ENGINE_EXPLICIT) G.IndexPredecessors();
+	FormulaDAG dag;
+	unordered_map<string, int> symbols;
+	for (int i = 0; i < model.symbols.size(); i++) symbols[model.symbols[i]] = i;
+	FormulaParser parser(dag, symbols);
+	FormulaChecker checker(dag, G, propositions);
+	checker.SetEngine(engine);
+	ROBDD real; //the symbolic engine also answers for encodings past the last node
+	real.FromRange(0, G.num_nodes - 1, G.Depth());
+	out << "{\"model\": " << Quote(model.name) << ", \"size\": " << model.size << ", \"states\": " << G.num_nodes << ", \"edges\": " << G.NumEdges();
+	out << ", \"engine\": " << Quote(engine == ENGINE_EXPLICIT ? "explicit" : "symbolic") << ", \"formulas\": [";
+	double check_ms = 0;
+	for (int i = 0; i < model.formulas.size(); i++)
+	{
+		int formula = parser.Parse(model.formulas[i]);
+		out << (i == 0 ? "" : ", ") << "{\"formula\": " << Quote(model.formulas[i]); //every formula gets an entry, so none vanishes from the record
+		if (formula == -1)
+		{
+			out << ", \"error\": " << Quote(parser.Error()) << "}";
+			continue;
+		}
+		chrono::steady_clock::time_point check_start = chrono::steady_clock::now();
+		ROBDD result = checker.Check(formula);
+		double ms = Milliseconds(check_start);
+		check_ms += ms;
+		out << ", \"ms\": " << ms << ", \"satisfied\": " << (long long)AND(result, real).SatCount(G.Depth()) << "}";
+	}
+	out << "], \"encode_ms\": " << encode_ms << ", \"apply_ms\": " << apply_ms << ", \"check_ms\": " << check_ms << ", \"wall_ms\": " << Milliseconds(start);
+	out << ", \"peak_live_nodes\": " << Manager().PeakNodes() << ", \"peak_rss_kb\": " << PeakRSS() / 1024;
+	out << ", \"nodes_allocated\": " << Manager().NodesAllocated() - allocated << ", \"gc_runs\": " << Manager().GCRuns() - gc_runs << ", \"reorder_runs\": " << Manager().ReorderRuns() - reorder_runs;
+	out << ", \"cache_hits\": " << Manager().CacheHits() - hits << ", \"cache_misses\": " << Manager().CacheMisses() - misses << "}";
+}
+
+void BenchmarkSuite(int scale, ostream& out)
+{
+	out << "[";
+	bool first = true;
+	for (int step = 1; step <= scale; step++)
+	{
+		for (int family = 0; family < 5; family++)
+		{
+			Model model;
+			if (family == 0) CounterModel(6 + 4 * step, model);
+			if (family == 1) TokenRingModel(4 + 2 * step, model);
+			if (family == 2) PhilosophersModel(3 + 2 * step, model);
+			if (family == 3) RandomModel(1000 << (2 * step - 2), 3, step, model);
+			if (family == 4) GridModel(32 * step, 32 * step, model);
+			for (int engine = ENGINE_SYMBOLIC; engine <= ENGINE_EXPLICIT; engine++)
+			{
+				out << (first ? "\n" : ",\n");
+				first = false;
+				RunModel(model, engine, out);
+				out.flush();
+			}
+		}
+	}
+	out << "\n]\n";
+}
@@ -0,0 +1,7 @@
+#pragma once
+#include<ostream>
+using namespace std;
+void BenchmarkThreads(int nodes, int max_threads, ostream& out); //times EG and EU on a random graph for 1, 2, 4.. max_threads workers
+void BenchmarkEngines(int nodes, ostream& out); //times EX, EG and EU on a random graph with the symbolic and the explicit engine
+void BenchmarkReorder(int bits, ostream& out); //builds the relation of a counter from an order that separates each bit from its next-state copy, then takes EX steps, with and without automatic reordering
+void BenchmarkSuite(int scale, ostream& out); //every model family of Models.h at scale growing sizes, both engines, one JSON record per run
@@ -0,0 +1,296 @@
+#include "Explicit.h"
+#include "Trace.h"
+#include <bitset>
+#include <algorithm>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+StateSet::StateSet()
+{
+	num_states = 0;
+}
+
+StateSet::StateSet(int num_states)
+{
+	this->num_states = num_states;
+	words.assign((num_states + 63) / 64, 0);
+}
+
+int StateSet::Count() const
+{
+	int ret = 0;
+	for (int i = 0; i < words.size(); i++) ret += bitset<64>(words[i]).count();
+	return ret;
+}
+
+bool StateSet::Empty() const
+{
+	for (int i = 0; i < words.size(); i++)
+	{
+		if (words[i] != 0) return false;
+	}
+	return true;
+}
+
+static void ClearTail(StateSet& states) //keeps the bits past num_states clear
+{
+	if (states.num_states % 64 != 0) states.words.back() &= (1ull << (states.num_states % 64)) - 1;
+}
+
+static void AndWords(const uint64_t* a, const uint64_t* b, uint64_t* out, size_t count)
+{
+	size_t i = 0;
+#ifdef __AVX2__
+	for (; i + 4 <= count; i += 4) _mm256_storeu_si256((__m256i*)(out + i), _mm256_and_si256(_mm256_loadu_si256((const __m256i*)(a + i)), _mm256_loadu_si256((const __m256i*)(b + i))));
+#endif
+	for (; i < count; i++) out[i] = a[i] & b[i];
+}
+
+static void OrWords(const uint64_t* a, const uint64_t* b, uint64_t* out, size_t count)
+{
+	size_t i = 0;
+#ifdef __AVX2__
+	for (; i + 4 <= count; i += 4) _mm256_storeu_si256((__m256i*)(out + i), _mm256_or_si256(_mm256_loadu_si256((const __m256i*)(a + i)), _mm256_loadu_si256((const __m256i*)(b + i))));
+#endif
+	for (; i < count; i++) out[i] = a[i] | b[i];
+}
+
+static void ImplyWords(const uint64_t* a, const uint64_t* b, uint64_t* out, size_t count) //NOT a OR b
+{
+	size_t i = 0;
+#ifdef __AVX2__
+	const __m256i ones = _mm256_set1_epi64x(-1);
+	for (; i + 4 <= count; i += 4) _mm256_storeu_si256((__m256i*)(out + i), _mm256_or_si256(_mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(a + i)), ones), _mm256_loadu_si256((const __m256i*)(b + i))));
+#endif
+	for (; i < count; i++) out[i] = ~a[i] | b[i];
+}
+
+static void NotWords(const uint64_t* a, uint64_t* out, size_t count)
+{
+	size_t i = 0;
+#ifdef __AVX2__
+	const __m256i ones = _mm256_set1_epi64x(-1);
+	for (; i + 4 <= count; i += 4) _mm256_storeu_si256((__m256i*)(out + i), _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(a + i)), ones));
+#endif
+	for (; i < count; i++) out[i] = ~a[i];
+}
+
+StateSet AND(const StateSet& states1, const StateSet& states2)
+{
+	StateSet ret(states1.num_states);
+	AndWords(states1.words.data(), states2.words.data(), ret.words.data(), ret.words.size());
+	return ret;
+}
+
+StateSet OR(const StateSet& states1, const StateSet& states2)
+{
+	StateSet ret(states1.num_states);
+	OrWords(states1.words.data(), states2.words.data(), ret.words.data(), ret.words.size());
+	return ret;
+}
+
+StateSet IMPLY(const StateSet& states1, const StateSet& states2)
+{
+	StateSet ret(states1.num_states);
+	ImplyWords(states1.words.data(), states2.words.data(), ret.words.data(), ret.words.size());
+	ClearTail(ret);
+	return ret;
+}
+
+StateSet NOT(const StateSet& states)
+{
+	StateSet ret(states.num_states);
+	NotWords(states.words.data(), ret.words.data(), ret.words.size());
+	ClearTail(ret);
+	return ret;
+}
+
+static void Fill(ROBDDRef node, uint64_t mask, uint64_t value, int depth, StateSet& states) //adds every state whose bits under mask equal value and that node accepts
+{
+	if (node == ROBDD_FALSE) return;
+	if (node == ROBDD_TRUE)
+	{
+		uint64_t free = ~mask & (depth < 64 ? (1ull << depth) - 1 : ~0ull);
+		uint64_t sub = 0;
+		do //every completion of the free bits
+		{
+			uint64_t state = value | sub;
+			if (state < (uint64_t)states.num_states) states.Insert(state);
+			sub = (sub - free) & free;
+		} while (sub != 0);
+		return;
+	}
+	ROBDDNode& n = Manager().Node(node);
+	ROBDDRef TrueNode = n.true_branch ^ (node & 1), FalseNode = n.false_branch ^ (node & 1);
+	if (n.label >= depth) //not a state bit, either value will do
+	{
+		Fill(TrueNode, mask, value, depth, states);
+		Fill(FalseNode, mask, value, depth, states);
+		return;
+	}
+	uint64_t bit = 1ull << (depth - 1 - n.label); //x_0 is the most significant bit
+	Fill(TrueNode, mask | bit, value | bit, depth, states);
+	Fill(FalseNode, mask | bit, value, depth, states);
+}
+
+StateSet ToStateSet(ROBDD robdd, int num_states, int depth)
+{
+	StateSet ret(num_states);
+	Fill(robdd.root, 0, 0, depth, ret);
+	return ret;
+}
+
+ROBDD ToROBDD(const StateSet& states, int depth)
+{
+	vector<int> TrueValues;
+	for (int i = 0; i < states.words.size(); i++)
+	{
+		for (uint64_t word = states.words[i]; word != 0; word &= word - 1) TrueValues.push_back(i * 64 + bitset<64>((word & (0 - word)) - 1).count());
+	}
+	ROBDD ret;
+	ret.FromTrueValueVector(TrueValues, depth);
+	return ret;
+}
+
+StateSet EX(const Graph& G, const StateSet& states)
+{ //states with a successor in states
+	if (Tracing(TRACE_STEPS)) TraceStream() << "\nImplementing EX explicitly...\n";
+	StateSet ret(G.num_nodes);
+	const int* offsets = G.Offsets();
+	const int* targets = G.Targets();
+	for (int i = 0; i < G.num_nodes; i++)
+	{
+		for (int j = offsets[i]; j < offsets[i + 1]; j++)
+		{
+			if (states.Contains(targets[j]))
+			{
+				ret.Insert(i);
+				break;
+			}
+		}
+	}
+	FlushTrace();
+	return ret;
+}
+
+struct ReverseIndex //predecessor lists, borrowed from the graph when it keeps them
+{
+	const Graph& G;
+	vector<int> offsets, sources;
+	ReverseIndex(const Graph& G) : G(G)
+	{
+		if (G.HasPredecessors()) return;
+		offsets.assign(G.num_nodes + 1, 0);
+		const int* targets = G.Targets();
+		for (int i = 0; i < G.NumEdges(); i++) offsets[targets[i] + 1]++;
+		for (int i = 0; i < G.num_nodes; i++) offsets[i + 1] += offsets[i];
+		vector<int> fill(offsets.begin(), offsets.end() - 1);
+		sources.resize(G.NumEdges());
+		for (int i = 0; i < G.num_nodes; i++)
+		{
+			for (int j = 0; j < G.OutDegree(i); j++) sources[fill[G.Successors(i)[j]]++] = i;
+		}
+	}
+	int InDegree(int state) const { return G.HasPredecessors() ? G.InDegree(state) : offsets[state + 1] - offsets[state]; }
+	const int* Predecessors(int state) const { return G.HasPredecessors() ? G.Predecessors(state) : sources.data() + offsets[state]; }
+};
+
+static StateSet Backward(const ReverseIndex& reverse, const StateSet& within, const StateSet& targets) //targets plus the states of within that reach them inside within
+{
+	StateSet ret = targets;
+	vector<int> queue;
+	for (int i = 0; i < targets.num_states; i++)
+	{
+		if (targets.Contains(i)) queue.push_back(i);
+	}
+	for (int head = 0; head < queue.size(); head++)
+	{
+		const int* predecessors = reverse.Predecessors(queue[head]);
+		for (int j = 0; j < reverse.InDegree(queue[head]); j++)
+		{
+			int state = predecessors[j];
+			if (ret.Contains(state) || !within.Contains(state)) continue;
+			ret.Insert(state);
+			queue.push_back(state);
+		}
+	}
+	return ret;
+}
+
+static StateSet FairSCCs(const Graph& G, const StateSet& within, const vector<StateSet>& fairness) //states of within on a cycle inside within whose SCC meets every fairness set, by Tarjan's algorithm without recursion
+{
+	StateSet ret(G.num_nodes);
+	vector<int> index(G.num_nodes, -1), low(G.num_nodes), stack;
+	vector<char> on_stack(G.num_nodes, 0);
+	vector<pair<int, int> > calls; //node and the position of its next successor
+	vector<char> met(fairness.size());
+	int counter = 0;
+	for (int root = 0; root < G.num_nodes; root++)
+	{
+		if (!within.Contains(root) || index[root] != -1) continue;
+		index[root] = low[root] = counter++;
+		stack.push_back(root);
+		on_stack[root] = 1;
+		calls.push_back(make_pair(root, 0));
+		while (!calls.empty())
+		{
+			int node = calls.back().first;
+			int position = calls.back().second;
+			if (position < G.OutDegree(node))
+			{
+				calls.back().second++;
+				int next = G.Successors(node)[position];
+				if (!within.Contains(next)) continue;
+				if (index[next] == -1)
+				{
+					index[next] = low[next] = counter++;
+					stack.push_back(next);
+					on_stack[next] = 1;
+					calls.push_back(make_pair(next, 0));
+				}
+				else if (on_stack[next]) low[node] = min(low[node], index[next]);
+				continue;
+			}
+			calls.pop_back();
+			if (!calls.empty()) low[calls.back().first] = min(low[calls.back().first], low[node]);
+			if (low[node] != index[node]) continue;
+			bool nontrivial = stack.back() != node; //more than one state
+			for (int j = 0; j < G.OutDegree(node) && !nontrivial; j++) nontrivial = G.Successors(node)[j] == node; //or a self loop
+			int bottom = find(stack.rbegin(), stack.rend(), node).base() - stack.begin() - 1; //the SCC is stack[bottom..]
+			fill(met.begin(), met.end(), 0);
+			for (int j = bottom; j < stack.size(); j++)
+			{
+				on_stack[stack[j]] = 0;
+				for (int k = 0; k < fairness.size(); k++) met[k] = met[k] || fairness[k].Contains(stack[j]);
+			}
+			bool fair = nontrivial && find(met.begin(), met.end(), 0) == met.end();
+			for (int j = bottom; j < stack.size() && fair; j++) ret.Insert(stack[j]);
+			stack.resize(bottom);
+		}
+	}
+	return ret;
+}
+
+StateSet EG(const Graph& G, const StateSet& states)
+{
+	return EG(G, states, vector<StateSet>());
+}
+
+StateSet EG(const Graph& G, const StateSet& states, const vector<StateSet>& fairness)
+{ //a state satisfies EG p iff it reaches, through p states, a cycle of p states visiting every fairness set
+	if (Tracing(TRACE_STEPS)) TraceStream() << "\nImplementing EG explicitly...\n";
+	StateSet cycles = FairSCCs(G, states, fairness);
+	if (Tracing(TRACE_STEPS)) TraceStream() << "\nStates on cycles: " << cycles.Count() << '\n';
+	StateSet ret = Backward(ReverseIndex(G), states, cycles);
+	FlushTrace();
+	return ret;
+}
+
+StateSet EU(const Graph& G, const StateSet& states1, const StateSet& states2)
+{
+	if (Tracing(TRACE_STEPS)) TraceStream() << "\nImplementing EU explicitly...\n";
+	StateSet ret = Backward(ReverseIndex(G), states1, states2);
+	FlushTrace();
+	return ret;
+}
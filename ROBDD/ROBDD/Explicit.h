@@ -0,0 +1,35 @@
+#pragma once
+#include<vector>
+#include<cstdint>
+#include"Graph.h"
+#include"ROBDD.h"
+using namespace std;
+enum CheckEngine
+{
+	ENGINE_SYMBOLIC, //state sets are ROBDDs, the graph is a transition relation
+	ENGINE_EXPLICIT //state sets are bitsets, the graph is walked directly
+};
+class StateSet //one bit per node of a graph
+{
+public:
+	int num_states;
+	vector<uint64_t> words; //bits past num_states are always clear
+	StateSet();
+	explicit StateSet(int num_states); //empty
+	bool Contains(int state) const { return (words[state >> 6] >> (state & 63) & 1) != 0; }
+	void Insert(int state) { words[state >> 6] |= 1ull << (state & 63); }
+	void Erase(int state) { words[state >> 6] &= ~(1ull << (state & 63)); }
+	int Count() const;
+	bool Empty() const;
+	bool operator==(const StateSet& other) const { return words == other.words; }
+};
+StateSet ToStateSet(ROBDD robdd, int num_states, int depth); //states below num_states, encoded with depth bits
+ROBDD ToROBDD(const StateSet& states, int depth);
+StateSet AND(const StateSet& states1, const StateSet& states2);
+StateSet OR(const StateSet& states1, const StateSet& states2);
+StateSet IMPLY(const StateSet& states1, const StateSet& states2);
+StateSet NOT(const StateSet& states);
+StateSet EX(const Graph& G, const StateSet& states); //one pass over the successor lists
+StateSet EG(const Graph& G, const StateSet& states); //nontrivial SCCs within states, then backward reachability
+StateSet EG(const Graph& G, const StateSet& states, const vector<StateSet>& fairness); //only SCCs that meet every fairness set
+StateSet EU(const Graph& G, const StateSet& states1, const StateSet& states2); //backward BFS, faster when G indexes its predecessors
@@ -0,0 +1,335 @@
+#include "Formula.h"
+#include "Parallel.h"
+#include "Trace.h"
+
+int FormulaDAG::Node(int op, int left, int right)
+{
+	unsigned long long key = ((unsigned long long)op << 60) | ((unsigned long long)(left + 1) << 30) | (unsigned long long)(right + 1);
+	unordered_map<unsigned long long, int>::iterator it = index.find(key);
+	if (it != index.end()) return it->second;
+	FormulaNode node;
+	node.op = op;
+	node.left = left;
+	node.right = right;
+	nodes.push_back(node);
+	index[key] = nodes.size() - 1;
+	return nodes.size() - 1;
+}
+
+int FormulaDAG::True()
+{
+	return Node(F_TRUE, -1, -1);
+}
+
+int FormulaDAG::Atom(int proposition)
+{
+	return Node(F_ATOM, proposition, -1);
+}
+
+int FormulaDAG::Make(int op, int left, int right)
+{
+	switch (op)
+	{
+	case F_NOT:
+		if (nodes[left].op == F_NOT) return nodes[left].left;
+		return Node(F_NOT, left, -1);
+	case F_AND:
+	case F_OR:
+		if (left > right) swap(left, right); //commutative, both orders share a node
+		return Node(op, left, right);
+	case F_AX: //AX p = NOT EX NOT p
+		return Make(F_NOT, Make(F_EX, Make(F_NOT, left)));
+	case F_AF: //AF p = NOT EG NOT p
+		return Make(F_NOT, Make(F_EG, Make(F_NOT, left)));
+	case F_EF: //EF p = E[True U p]
+		return Make(F_EU, True(), left);
+	case F_AG: //AG p = NOT E[True U NOT p]
+		return Make(F_NOT, Make(F_EU, True(), Make(F_NOT, left)));
+	case F_AU: //A[p U q] = NOT (E[NOT q U (NOT p AND NOT q)] OR EG NOT q)
+		return Make(F_NOT, Make(F_OR, Make(F_EU, Make(F_NOT, right), Make(F_AND, Make(F_NOT, left), Make(F_NOT, right))), Make(F_EG, Make(F_NOT, right))));
+	default:
+		return Node(op, left, right);
+	}
+}
+
+static const Graph no_graph; //of checkers given a relation
+
+FormulaChecker::FormulaChecker(FormulaDAG& dag, const Graph& G, vector<ROBDD>& propositions) : dag(dag), G(G), propositions(propositions)
+{
+	engine = ENGINE_SYMBOLIC;
+	given = false;
+	revision = -1;
+	witness_budget = 0;
+}
+
+FormulaChecker::FormulaChecker(FormulaDAG& dag, const TransitionRelation& R, vector<ROBDD>& propositions) : dag(dag), G(no_graph), propositions(propositions)
+{
+	engine = ENGINE_SYMBOLIC;
+	given = true;
+	relation = R;
+	revision = -1;
+	witness_budget = 0;
+}
+
+void FormulaChecker::SetEngine(int engine)
+{
+	if (!given) this->engine = engine; //the explicit engine needs the graph
+	revision = -1;
+}
+
+void FormulaChecker::SetFairness(const vector<ROBDD>& constraints)
+{
+	fairness = constraints;
+	revision = -1;
+}
+
+void FormulaChecker::SetWitnessBudget(size_t nodes)
+{
+	witness_budget = nodes;
+	revision = -1;
+}
+
+void FormulaChecker::Evaluate(int node)
+{
+	FormulaNode& f = dag.nodes[node];
+	ROBDD ret;
+	switch (f.op)
+	{
+	case F_TRUE:
+		ret.FromConstant(1);
+		break;
+	case F_ATOM:
+		ret = propositions[f.left];
+		break;
+	case F_NOT:
+		ret = NOT(results[f.left]);
+		break;
+	case F_AND:
+		ret = AND(results[f.left], results[f.right]);
+		break;
+	case F_OR:
+		ret = OR(results[f.left], results[f.right]);
+		break;
+	case F_IMPLY:
+		ret = IMPLY(results[f.left], results[f.right]);
+		break;
+	case F_EX: //a fair path continues from the successor
+		ret = EX(relation, AND(results[f.left], fair));
+		break;
+	case F_EG:
+		ret = Globally(results[f.left]);
+		break;
+	case F_EU:
+		if (witness_budget > 0) rings[node] = OnionRings(witness_budget);
+		ret = EU(relation, results[f.left], AND(results[f.right], fair), witness_budget > 0 ? &rings[node] : NULL);
+		break;
+	}
+	results[node] = ret;
+	evaluated[node] = 1;
+}
+
+void FormulaChecker::EvaluateExplicit(int node)
+{
+	FormulaNode& f = dag.nodes[node];
+	StateSet ret;
+	switch (f.op)
+	{
+	case F_TRUE:
+		ret = NOT(StateSet(G.num_nodes));
+		break;
+	case F_ATOM:
+		ret = atoms[f.left];
+		break;
+	case F_NOT:
+		ret = NOT(sets[f.left]);
+		break;
+	case F_AND:
+		ret = AND(sets[f.left], sets[f.right]);
+		break;
+	case F_OR:
+		ret = OR(sets[f.left], sets[f.right]);
+		break;
+	case F_IMPLY:
+		ret = IMPLY(sets[f.left], sets[f.right]);
+		break;
+	case F_EX:
+		ret = EX(G, AND(sets[f.left], fair_states));
+		break;
+	case F_EG:
+		ret = EG(G, sets[f.left], fair_sets);
+		break;
+	case F_EU:
+		ret = EU(G, sets[f.left], AND(sets[f.right], fair_states));
+		break;
+	}
+	sets[node] = ret;
+	evaluated[node] = 1;
+}
+
+struct EvaluateTask : Task
+{
+	FormulaChecker* checker;
+	const vector<int>* batch;
+	int first, last;
+};
+
+static void RunEvaluate(Task* task)
+{
+	EvaluateTask* evaluate = (EvaluateTask*)task;
+	evaluate->checker->EvaluateRange(*evaluate->batch, evaluate->first, evaluate->last);
+}
+
+void FormulaChecker::EvaluateRange(const vector<int>& batch, int first, int last) //splits the batch in halves, one of them for whoever steals it
+{
+	if (last - first == 1)
+	{
+		if (engine == ENGINE_EXPLICIT) EvaluateExplicit(batch[first]);
+		else Evaluate(batch[first]);
+		return;
+	}
+	int middle = (first + last) / 2;
+	EvaluateTask task;
+	task.run = RunEvaluate;
+	task.checker = this;
+	task.batch = &batch;
+	task.first = first;
+	task.last = middle;
+	Spawn(task);
+	EvaluateRange(batch, middle, last);
+	Sync(task);
+}
+
+ROBDD FormulaChecker::Check(int formula)
+{
+	return Check(vector<int>(1, formula))[0];
+}
+
+vector<ROBDD> FormulaChecker::Check(vector<int> formulas)
+{
+	if (given ? revision == -1 : (revision != G.revision || (engine == ENGINE_SYMBOLIC && relation.threshold != PartitionThreshold()))) //results of an older graph are stale
+	{
+		ROBDD all;
+		all.FromConstant(1);
+		if (engine == ENGINE_SYMBOLIC)
+		{
+			if (!given) relation.FromGraph(G, PartitionThreshold());
+			fair = fairness.empty() ? all : Globally(all);
+		}
+		else
+		{
+			atoms.clear();
+			for (int i = 0; i < propositions.size(); i++) atoms.push_back(ToStateSet(propositions[i], G.num_nodes, G.Depth()));
+			fair_sets.clear();
+			for (int i = 0; i < fairness.size(); i++) fair_sets.push_back(ToStateSet(fairness[i], G.num_nodes, G.Depth()));
+			fair_states = NOT(StateSet(G.num_nodes));
+			if (!fairness.empty()) fair_states = EG(G, fair_states, fair_sets);
+		}
+		revision = given ? 0 : G.revision;
+		results.clear();
+		sets.clear();
+		evaluated.clear();
+		converted.clear();
+		rings.clear();
+	}
+	results.resize(dag.nodes.size());
+	sets.resize(dag.nodes.size());
+	evaluated.resize(dag.nodes.size(), 0);
+	converted.resize(dag.nodes.size(), 0);
+	rings.resize(dag.nodes.size());
+	vector<int> level(dag.nodes.size(), -1); //-1 for nodes that are not needed or already known
+	vector<char> needed(dag.nodes.size(), 0);
+	for (int i = 0; i < formulas.size(); i++) needed[formulas[i]] = 1;
+	for (int i = dag.nodes.size() - 1; i >= 0; i--) //parents come after their children
+	{
+		if (!needed[i] || evaluated[i]) continue;
+		if (dag.nodes[i].op != F_ATOM && dag.nodes[i].left >= 0) needed[dag.nodes[i].left] = 1;
+		if (dag.nodes[i].right >= 0) needed[dag.nodes[i].right] = 1;
+	}
+	vector<vector<int> > batches; //nodes of a batch only depend on earlier batches
+	for (int i = 0; i < dag.nodes.size(); i++)
+	{
+		if (!needed[i] || evaluated[i]) continue;
+		if (dag.nodes[i].op != F_ATOM && dag.nodes[i].left >= 0) level[i] = max(level[i], level[dag.nodes[i].left] + 1);
+		if (dag.nodes[i].right >= 0) level[i] = max(level[i], level[dag.nodes[i].right] + 1);
+		if (level[i] < 0) level[i] = 0;
+		if (level[i] >= batches.size()) batches.resize(level[i] + 1);
+		batches[level[i]].push_back(i);
+	}
+	for (int i = 0; i < batches.size(); i++)
+	{
+		Manager().MaybeCollect(); //every finished subformula is held in results
+		bool parallel = Workers() > 1 && batches[i].size() > 1 && !Tracing(TRACE_STEPS); //traces of concurrent kernels would interleave
+		if (parallel)
+		{
+			Manager().AddVariables((given ? relation.depth : G.Depth()) * 2); //every variable the kernels may meet, see AddVariables
+			Manager().BeginConcurrent();
+			BeginParallel();
+			EvaluateRange(batches[i], 0, batches[i].size());
+			EndParallel();
+			Manager().EndConcurrent();
+		}
+		else
+		{
+			for (int j = 0; j < batches[i].size(); j++)
+			{
+				if (engine == ENGINE_EXPLICIT) EvaluateExplicit(batches[i][j]);
+				else Evaluate(batches[i][j]);
+			}
+		}
+	}
+	vector<ROBDD> ret;
+	for (int i = 0; i < formulas.size(); i++) ret.push_back(Result(formulas[i]));
+	return ret;
+}
+
+ROBDD FormulaChecker::Globally(ROBDD states)
+{
+	if (!given && G.num_nodes <= ExplicitCutoff()) return EG(G, states, fairness);
+	return EG(relation, states, fairness);
+}
+
+ROBDD FormulaChecker::Result(int node)
+{
+	if (engine == ENGINE_EXPLICIT && !converted[node])
+	{
+		results[node] = ToROBDD(sets[node], G.Depth());
+		converted[node] = 1;
+	}
+	return results[node];
+}
+
+vector<ROBDD> FormulaChecker::Witness(int formula, ROBDD start)
+{
+	Check(formula);
+	if (dag.nodes[formula].op == F_NOT) formula = dag.nodes[formula].left; //a counterexample to NOT f is a witness of f
+	start = AND(start, Result(formula));
+	FormulaNode& f = dag.nodes[formula];
+	vector<ROBDD> ret;
+	if (start.root == ROBDD_FALSE) return ret;
+	if (engine == ENGINE_EXPLICIT) //the explicit engine has no relation of its own
+	{
+		if (relation.revision != G.revision || relation.threshold != PartitionThreshold()) relation.FromGraph(G, PartitionThreshold());
+		fair = ToROBDD(fair_states, G.Depth());
+	}
+	OnionRings recomputed;
+	switch (f.op)
+	{
+	case F_EX:
+		ret.push_back(start.PickOne(relation.depth));
+		ret.push_back(relation.Image(ret[0], AND(Result(f.left), fair)).PickOne(relation.depth));
+		break;
+	case F_EG:
+		ret = Lasso(relation, Result(f.left), fairness, start, witness_budget);
+		break;
+	case F_EU:
+		if (engine == ENGINE_SYMBOLIC && witness_budget > 0)
+		{
+			ret = ::Witness(relation, rings[formula], start);
+			break;
+		}
+		EU(relation, Result(f.left), AND(Result(f.right), fair), &recomputed);
+		ret = ::Witness(relation, recomputed, start);
+		break;
+	}
+	return ret;
+}
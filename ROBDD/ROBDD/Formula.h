@@ -0,0 +1,75 @@
+#pragma once
+#include<vector>
+#include<unordered_map>
+#include"ROBDD.h"
+#include"Explicit.h"
+using namespace std;
+enum FormulaOp
+{
+	F_TRUE,
+	F_ATOM, //left is the index of the proposition
+	F_NOT,
+	F_AND,
+	F_OR,
+	F_IMPLY,
+	F_EX,
+	F_EG,
+	F_EU,
+	F_AX, //the rest are rewritten by FormulaDAG::Make in terms of the ones above
+	F_AF,
+	F_EF,
+	F_AG,
+	F_AU
+};
+struct FormulaNode
+{
+	int op;
+	int left, right; //children, -1 if unused
+};
+class FormulaDAG //hash-consed, so every distinct subformula is stored once
+{
+public:
+	vector<FormulaNode> nodes; //children come before their parents
+	int True();
+	int Atom(int proposition);
+	int Make(int op, int left, int right = -1);
+private:
+	unordered_map<unsigned long long, int> index;
+	int Node(int op, int left, int right);
+};
+class FormulaChecker //evaluates the nodes of a DAG on one model, each at most once
+{
+public:
+	FormulaChecker(FormulaDAG& dag, const Graph& G, vector<ROBDD>& propositions);
+	FormulaChecker(FormulaDAG& dag, const TransitionRelation& R, vector<ROBDD>& propositions); //a model known by its relation alone, always checked symbolically
+	void SetEngine(int engine); //ENGINE_SYMBOLIC by default, switching drops the results so far. Explicit results leave out encodings past the last node
+	void SetFairness(const vector<ROBDD>& constraints); //path quantifiers only range over paths visiting every constraint infinitely often
+	void SetWitnessBudget(size_t nodes); //EU nodes keep their onion rings for Witness, up to this many nodes each, 0 (default) keeps none
+	ROBDD Check(int formula);
+	vector<ROBDD> Check(vector<int> formulas); //independent subformulas are evaluated side by side when there are workers
+	vector<ROBDD> Witness(int formula, ROBDD start); //for an EX, EU or EG node a path showing a state of start satisfies it, for the negation of one a path showing a state violates it. See Lasso for EG
+	void EvaluateRange(const vector<int>& batch, int first, int last);
+private:
+	FormulaDAG& dag;
+	const Graph& G;
+	vector<ROBDD>& propositions;
+	int engine;
+	bool given; //the relation came from the caller and there is no graph
+	long long revision; //revision of the graph the results belong to
+	TransitionRelation relation;
+	vector<ROBDD> results; //by DAG node
+	vector<StateSet> sets; //by DAG node, for the explicit engine
+	vector<StateSet> atoms; //the propositions as state sets
+	vector<ROBDD> fairness;
+	vector<StateSet> fair_sets;
+	ROBDD fair; //states with a fair path, all of them without constraints
+	StateSet fair_states;
+	vector<char> evaluated;
+	vector<char> converted; //results already holds the ROBDD of the set
+	size_t witness_budget;
+	vector<OnionRings> rings; //by DAG node, kept for EU nodes while witness_budget is set
+	ROBDD Result(int node); //converts the set of the explicit engine on first use
+	ROBDD Globally(ROBDD states); //EG under the fairness constraints, on the graph itself while it is within ExplicitCutoff
+	void Evaluate(int node);
+	void EvaluateExplicit(int node);
+};
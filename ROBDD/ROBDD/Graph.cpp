@@ -1,21 +1,112 @@
-#include "Graph.h"
-
-Graph::Graph()
-{
-	num_nodes = 0;
-}
-
-void Graph::AddNode(int value)
-{
-	num_nodes++;
-	GraphNode* NewNode = new GraphNode;
-	nodes.push_back(NewNode);
-	nodes[num_nodes - 1]->value = value;
-}
-
-void Graph::AddEdge(int nodesrc, int nodedst)
-{
-	if (nodesrc < 0 || nodedst < 0 || nodesrc >= num_nodes || nodedst >= num_nodes) throw "Added an illegal edge!";
-	nodes[nodesrc]->next.push_back(nodes[nodedst]);
-	nodes[nodesrc]->nextidx.push_back(nodedst);
-}
+#include "Graph.h"
+#include "MathFunc.h"
+
+static long long graph_revisions = 0;
+
+Graph::Graph()
+{
+	num_nodes = 0;
+	offsets.push_back(0);
+	reverse_offsets.push_back(0);
+	reverse = false;
+	revision = ++graph_revisions;
+}
+
+void Graph::AddNode(int value)
+{
+	Settle(); //pending edges belong to the current nodes
+	num_nodes++;
+	values.push_back(value);
+	offsets.push_back(offsets.back());
+	reverse_offsets.push_back(reverse_offsets.back());
+	revision = ++graph_revisions;
+}
+
+void Graph::AddEdge(int nodesrc, int nodedst)
+{
+	if (nodesrc < 0 || nodedst < 0 || nodesrc >= num_nodes || nodedst >= num_nodes) throw "Added an illegal edge!";
+	pending_sources.push_back(nodesrc);
+	pending_targets.push_back(nodedst);
+	revision = ++graph_revisions;
+}
+
+bool Graph::SetEdges(const vector<int>& sources, const vector<int>& destinations)
+{
+	if (sources.size() != destinations.size()) return false;
+	for (int i = 0; i < sources.size(); i++)
+	{
+		if (sources[i] < 0 || destinations[i] < 0 || sources[i] >= num_nodes || destinations[i] >= num_nodes) return false;
+	}
+	offsets.assign(num_nodes + 1, 0);
+	targets.clear();
+	pending_sources = sources;
+	pending_targets = destinations;
+	Merge();
+	revision = ++graph_revisions;
+	return true;
+}
+
+bool Graph::SetEdges(const int* offsets, const int* targets)
+{
+	if (offsets[0] != 0) return false;
+	for (int i = 0; i < num_nodes; i++)
+	{
+		if (offsets[i] > offsets[i + 1]) return false;
+	}
+	for (int i = 0; i < offsets[num_nodes]; i++)
+	{
+		if (targets[i] < 0 || targets[i] >= num_nodes) return false;
+	}
+	this->offsets.assign(offsets, offsets + num_nodes + 1);
+	this->targets.assign(targets, targets + offsets[num_nodes]);
+	pending_sources.clear();
+	pending_targets.clear();
+	if (reverse) Reverse();
+	revision = ++graph_revisions;
+	return true;
+}
+
+void Graph::IndexPredecessors()
+{
+	Settle();
+	reverse = true;
+	Reverse();
+}
+
+void Graph::Merge() const //counting sort of the pending edges by source, after the edges each node already has
+{
+	vector<int> merged(num_nodes + 1, 0);
+	for (int i = 0; i < num_nodes; i++) merged[i + 1] = offsets[i + 1] - offsets[i];
+	for (int i = 0; i < pending_sources.size(); i++) merged[pending_sources[i] + 1]++;
+	for (int i = 0; i < num_nodes; i++) merged[i + 1] += merged[i];
+	vector<int> fill(merged.begin(), merged.end() - 1); //next free slot of each node
+	vector<int> ret(merged[num_nodes]);
+	for (int i = 0; i < num_nodes; i++)
+	{
+		for (int j = offsets[i]; j < offsets[i + 1]; j++) ret[fill[i]++] = targets[j];
+	}
+	for (int i = 0; i < pending_sources.size(); i++) ret[fill[pending_sources[i]]++] = pending_targets[i];
+	offsets.swap(merged);
+	targets.swap(ret);
+	pending_sources.clear();
+	pending_targets.clear();
+	if (reverse) Reverse();
+}
+
+void Graph::Reverse() const
+{
+	reverse_offsets.assign(num_nodes + 1, 0);
+	for (int i = 0; i < targets.size(); i++) reverse_offsets[targets[i] + 1]++;
+	for (int i = 0; i < num_nodes; i++) reverse_offsets[i + 1] += reverse_offsets[i];
+	vector<int> fill(reverse_offsets.begin(), reverse_offsets.end() - 1);
+	sources.resize(targets.size());
+	for (int i = 0; i < num_nodes; i++)
+	{
+		for (int j = offsets[i]; j < offsets[i + 1]; j++) sources[fill[targets[j]]++] = i;
+	}
+}
+
+int Graph::Depth() const
+{
+	return BitsFor(num_nodes);
+}
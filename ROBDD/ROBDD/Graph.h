@@ -1,19 +1,35 @@
-#pragma once
-#include<vector>
-#include<cstdlib>
-using namespace std;
-struct GraphNode
-{
-	int value;
-	vector<GraphNode*> next;
-	vector<int> nextidx; //corresponding index
-};
-class Graph
-{
-public:
-	int num_nodes;
-	vector<GraphNode*> nodes;
-	Graph();
-	void AddNode(int value);
-	void AddEdge(int nodesrc, int nodedst); //Add an edge from nodesrc to nodedst
-};
\ No newline at end of file
+#pragma once
+#include<vector>
+#include<cstdlib>
+using namespace std;
+class Graph //compressed sparse row: the successors of node i are Targets()[Offsets()[i]..Offsets()[i+1]-1]
+{
+public:
+	int num_nodes;
+	long long revision; //changes whenever the graph does, unique across graphs
+	Graph();
+	void AddNode(int value);
+	void AddEdge(int nodesrc, int nodedst); //Add an edge from nodesrc to nodedst, merged into the arrays on the next read
+	bool SetEdges(const vector<int>& sources, const vector<int>& destinations); //replaces every edge in O(V+E), false and nothing changed if the lists differ in length or name a missing node
+	bool SetEdges(const int* offsets, const int* targets); //replaces every edge with arrays already in CSR form, num_nodes + 1 offsets, false and nothing changed if they are malformed
+	void IndexPredecessors(); //builds the reverse index, kept up to date from then on
+	int Value(int node) const { return values[node]; }
+	int NumEdges() const { return Offsets()[num_nodes]; }
+	int Depth() const; //number of bits encoding a node index
+	const int* Offsets() const { Settle(); return offsets.data(); }
+	const int* Targets() const { Settle(); return targets.data(); }
+	int OutDegree(int node) const { return Offsets()[node + 1] - Offsets()[node]; }
+	const int* Successors(int node) const { return Targets() + Offsets()[node]; }
+	bool HasPredecessors() const { return reverse; }
+	int InDegree(int node) const { Settle(); return reverse_offsets[node + 1] - reverse_offsets[node]; }
+	const int* Predecessors(int node) const { Settle(); return sources.data() + reverse_offsets[node]; } //only with the reverse index
+private:
+	vector<int> values;
+	mutable vector<int> offsets, targets;
+	mutable vector<int> reverse_offsets, sources; //predecessors of node i are sources[reverse_offsets[i]..reverse_offsets[i+1]-1]
+	mutable vector<int> pending_sources, pending_targets; //edges added since the arrays were built
+	bool reverse;
+	void Settle() const { if (!pending_sources.empty()) Merge(); } //not safe while another thread reads the graph
+	void Merge() const;
+	void Reverse() const;
+};
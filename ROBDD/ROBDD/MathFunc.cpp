@@ -1,12 +1,19 @@
-#include "MathFunc.h"
-
-vector<bool> IntToBinVec(int num, int len)
-{
-	vector<bool> ret; //vector to be returned
-	while(ret.size()<len)
-	{
-		ret.insert(ret.begin(), num % 2);
-		num /= 2;
-	}
-	return ret;
-}
+#include "MathFunc.h"
+
+vector<bool> IntToBinVec(int num, int len)
+{
+	vector<bool> ret; //vector to be returned
+	while(ret.size()<len)
+	{
+		ret.insert(ret.begin(), num % 2);
+		num /= 2;
+	}
+	return ret;
+}
+
+int BitsFor(unsigned long long count)
+{
+	int ret = 0;
+	while (ret < 64 && (1ull << ret) < count) ret++;
+	return ret;
+}
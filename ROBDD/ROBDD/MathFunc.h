@@ -1,4 +1,5 @@
-#pragma once
-#include<vector>
-using namespace std;
-vector<bool> IntToBinVec(int num, int len); //len represents the length of returned vector
\ No newline at end of file
+#pragma once
+#include<vector>
+using namespace std;
+vector<bool> IntToBinVec(int num, int len); //len represents the length of returned vector
+int BitsFor(unsigned long long count); //bits that number count states, 0 for a single state
@@ -0,0 +1,276 @@
+#include "ModelFile.h"
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#include <fstream>
+#include <cstring>
+#include <algorithm>
+#include <unordered_map>
+
+static const char MODEL_MAGIC[8] = { 'R', 'O', 'B', 'D', 'D', 'M', 'F', '1' };
+static const uint32_t MODEL_VERSION = 1;
+
+static size_t Align(size_t bytes)
+{
+	return (bytes + 7) & ~(size_t)7;
+}
+
+struct ModelLayout //byte offset of each section
+{
+	size_t order, nodes, roots, names, values, offsets, targets, end;
+	ModelLayout(const ModelHeader& header)
+	{
+		order = Align(sizeof(ModelHeader));
+		nodes = order + Align((size_t)header.num_vars * sizeof(int32_t));
+		roots = nodes + Align((size_t)header.num_nodes * sizeof(ModelNode));
+		names = roots + Align((size_t)header.num_roots * sizeof(uint32_t));
+		values = names + Align(header.names_bytes);
+		offsets = values + Align((size_t)header.num_vertices * sizeof(int32_t));
+		targets = offsets + Align(header.num_vertices == 0 ? 0 : ((size_t)header.num_vertices + 1) * sizeof(int32_t));
+		end = targets + Align((size_t)header.num_edges * sizeof(int32_t));
+	}
+};
+
+static uint32_t Encode(ROBDDRef node, vector<ModelNode>& table, unordered_map<ROBDDRef, uint32_t>& index) //children are numbered before their parents
+{
+	ROBDDRef regular = Regular(node);
+	unordered_map<ROBDDRef, uint32_t>::iterator found = index.find(regular);
+	if (found == index.end())
+	{
+		ModelNode entry;
+		entry.label = Manager().Node(regular).label;
+		entry.true_branch = Encode(Manager().Node(regular).true_branch, table, index);
+		entry.false_branch = Encode(Manager().Node(regular).false_branch, table, index);
+		table.push_back(entry);
+		found = index.insert(make_pair(regular, (uint32_t)table.size())).first;
+	}
+	return found->second << 1 | (IsComplement(node) ? 1 : 0);
+}
+
+static void WriteSection(ofstream& out, const void* data, size_t bytes) //pads the section to 8 bytes
+{
+	static const char zeros[8] = { 0 };
+	if (bytes != 0) out.write((const char*)data, bytes);
+	out.write(zeros, Align(bytes) - bytes);
+}
+
+bool SaveModel(const string& path, const Graph* G, const vector<string>& names, vector<ROBDD>& roots)
+{
+	vector<ModelNode> table;
+	unordered_map<ROBDDRef, uint32_t> index;
+	index[ROBDD_TRUE] = 0;
+	vector<uint32_t> edges;
+	for (int i = 0; i < roots.size(); i++) edges.push_back(Encode(roots[i].root, table, index));
+	vector<int32_t> order;
+	for (int i = 0; i < Manager().NumVars(); i++) order.push_back(Manager().VarAt(i));
+	string packed;
+	for (int i = 0; i < roots.size(); i++)
+	{
+		if (i < names.size()) packed += names[i];
+		packed += '\0';
+	}
+	vector<int32_t> values, offsets, targets;
+	if (G != NULL && G->num_nodes > 0)
+	{
+		for (int i = 0; i < G->num_nodes; i++) values.push_back(G->Value(i));
+		offsets.assign(G->Offsets(), G->Offsets() + G->num_nodes + 1);
+		targets.assign(G->Targets(), G->Targets() + G->NumEdges());
+	}
+	ModelHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, MODEL_MAGIC, sizeof(MODEL_MAGIC));
+	header.version = MODEL_VERSION;
+	header.num_vars = order.size();
+	header.num_nodes = table.size();
+	header.num_roots = edges.size();
+	header.names_bytes = packed.size();
+	header.num_vertices = values.size();
+	header.num_edges = targets.size();
+	ofstream out(path.c_str(), ios::binary | ios::trunc);
+	if (!out) return false;
+	WriteSection(out, &header, sizeof(header));
+	WriteSection(out, order.data(), order.size() * sizeof(int32_t));
+	WriteSection(out, table.data(), table.size() * sizeof(ModelNode));
+	WriteSection(out, edges.data(), edges.size() * sizeof(uint32_t));
+	WriteSection(out, packed.data(), packed.size());
+	WriteSection(out, values.data(), values.size() * sizeof(int32_t));
+	WriteSection(out, offsets.data(), offsets.size() * sizeof(int32_t));
+	WriteSection(out, targets.data(), targets.size() * sizeof(int32_t));
+	return (bool)out;
+}
+
+ModelFile::ModelFile()
+{
+	data = NULL;
+	size = 0;
+#ifdef _WIN32
+	file = INVALID_HANDLE_VALUE;
+	mapping = NULL;
+#endif
+	header = NULL;
+}
+
+ModelFile::~ModelFile()
+{
+	Close();
+}
+
+bool ModelFile::Open(const string& path)
+{
+	Close();
+	error.clear();
+#ifdef _WIN32
+	file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE) return Fail("cannot open " + path);
+	LARGE_INTEGER bytes;
+	if (!GetFileSizeEx(file, &bytes)) return Fail("cannot read the size of " + path);
+	size = bytes.QuadPart;
+	if (size < sizeof(ModelHeader)) return Fail("file too short");
+	mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapping == NULL) return Fail("cannot map " + path);
+	data = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (data == NULL) return Fail("cannot map " + path);
+#else
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0) return Fail("cannot open " + path);
+	struct stat info;
+	if (fstat(fd, &info) != 0)
+	{
+		close(fd);
+		return Fail("cannot read the size of " + path);
+	}
+	size = info.st_size;
+	if (size < sizeof(ModelHeader))
+	{
+		close(fd);
+		return Fail("file too short");
+	}
+	void* mapped = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd); //the mapping keeps the file alive
+	if (mapped == MAP_FAILED) return Fail("cannot map " + path);
+	data = (const char*)mapped;
+#endif
+	header = (const ModelHeader*)data;
+	if (memcmp(header->magic, MODEL_MAGIC, sizeof(MODEL_MAGIC)) != 0) return Fail("not a model file");
+	if (header->version != MODEL_VERSION) return Fail("unsupported version");
+	ModelLayout layout(*header);
+	if (layout.end > size) return Fail("file truncated");
+	order = (const int32_t*)(data + layout.order);
+	nodes = (const ModelNode*)(data + layout.nodes);
+	roots = (const uint32_t*)(data + layout.roots);
+	names = data + layout.names;
+	values = (const int32_t*)(data + layout.values);
+	offsets = (const int32_t*)(data + layout.offsets);
+	targets = (const int32_t*)(data + layout.targets);
+	return Validate();
+}
+
+void ModelFile::Close()
+{
+#ifdef _WIN32
+	if (data != NULL) UnmapViewOfFile(data);
+	if (mapping != NULL) CloseHandle(mapping);
+	if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+	mapping = NULL;
+	file = INVALID_HANDLE_VALUE;
+#else
+	if (data != NULL) munmap((void*)data, size);
+#endif
+	data = NULL;
+	size = 0;
+	header = NULL;
+}
+
+string ModelFile::Error()
+{
+	return error;
+}
+
+bool ModelFile::Fail(const string& message)
+{
+	Close();
+	error = message;
+	return false;
+}
+
+bool ModelFile::Validate() //so that a damaged file cannot produce an unreduced or cyclic diagram
+{
+	uint32_t num_vars = header->num_vars, num_nodes = header->num_nodes;
+	vector<int> level(num_vars, -1);
+	for (uint32_t i = 0; i < num_vars; i++)
+	{
+		if (order[i] < 0 || order[i] >= num_vars || level[order[i]] != -1) return Fail("variable order is not a permutation");
+		level[order[i]] = i;
+	}
+	for (uint32_t i = 0; i < num_nodes; i++)
+	{
+		const ModelNode& node = nodes[i];
+		if (node.label < 0 || node.label >= num_vars) return Fail("node label out of range");
+		if ((node.true_branch >> 1) > i || (node.false_branch >> 1) > i) return Fail("nodes out of topological order");
+		if ((node.true_branch & 1) != 0 || node.true_branch == node.false_branch) return Fail("node table not reduced");
+		uint32_t children[2] = { node.true_branch >> 1, node.false_branch >> 1 };
+		for (int j = 0; j < 2; j++)
+		{
+			if (children[j] != 0 && level[nodes[children[j] - 1].label] <= level[node.label]) return Fail("node table does not follow the variable order");
+		}
+	}
+	for (uint32_t i = 0; i < header->num_roots; i++)
+	{
+		if ((roots[i] >> 1) > num_nodes) return Fail("root out of range");
+	}
+	if (count(names, names + header->names_bytes, '\0') < header->num_roots) return Fail("missing root names");
+	if (header->num_vertices == 0) return header->num_edges == 0 || Fail("edges without vertices");
+	if (offsets[0] != 0 || (uint32_t)offsets[header->num_vertices] != header->num_edges) return Fail("bad edge offsets");
+	for (uint32_t i = 0; i < header->num_vertices; i++)
+	{
+		if (offsets[i] > offsets[i + 1]) return Fail("bad edge offsets");
+	}
+	for (uint32_t i = 0; i < header->num_edges; i++)
+	{
+		if (targets[i] < 0 || targets[i] >= header->num_vertices) return Fail("edge target out of range");
+	}
+	return true;
+}
+
+vector<string> ModelFile::Names()
+{
+	vector<string> ret;
+	const char* name = names;
+	for (uint32_t i = 0; i < header->num_roots; i++)
+	{
+		ret.push_back(name);
+		name += ret.back().size() + 1;
+	}
+	return ret;
+}
+
+vector<ROBDD> ModelFile::Roots()
+{
+	Manager().MaybeCollect();
+	Manager().SetOrder(vector<int>(order, order + header->num_vars));
+	vector<ROBDDRef> built(header->num_nodes + 1); //by table index
+	built[0] = ROBDD_TRUE;
+	for (uint32_t i = 0; i < header->num_nodes; i++)
+	{
+		const ModelNode& node = nodes[i];
+		ROBDDRef TrueNode = built[node.true_branch >> 1] ^ (node.true_branch & 1);
+		ROBDDRef FalseNode = built[node.false_branch >> 1] ^ (node.false_branch & 1);
+		built[i + 1] = Manager().MakeNode(node.label, TrueNode, FalseNode);
+	}
+	vector<ROBDD> ret(header->num_roots);
+	for (uint32_t i = 0; i < header->num_roots; i++) ret[i].root = built[roots[i] >> 1] ^ (roots[i] & 1);
+	return ret;
+}
+
+void ModelFile::LoadGraph(Graph& G)
+{
+	G = Graph();
+	for (uint32_t i = 0; i < header->num_vertices; i++) G.AddNode(values[i]);
+	G.SetEdges(offsets, targets);
+}
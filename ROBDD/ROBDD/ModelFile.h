@@ -0,0 +1,69 @@
+#pragma once
+#include<vector>
+#include<string>
+#include<cstdint>
+#include"Graph.h"
+#include"ROBDD.h"
+using namespace std;
+//Binary model file, native byte order, every section aligned to 8 bytes:
+//header, variable order (top level first), node table (children before parents),
+//root edges, root names (NUL-terminated), then the graph in CSR form:
+//vertex values, num_vertices + 1 edge offsets and the edge targets.
+//Node and root edges are ROBDDRefs into the table: index 0 is the leaf, entry i of the table is index i + 1.
+struct ModelHeader
+{
+	char magic[8]; //"ROBDDMF1"
+	uint32_t version;
+	uint32_t num_vars;
+	uint32_t num_nodes; //table entries, the leaf not included
+	uint32_t num_roots;
+	uint32_t names_bytes;
+	uint32_t num_vertices; //0 for a file without a graph
+	uint32_t num_edges;
+	uint32_t reserved;
+};
+struct ModelNode
+{
+	int32_t label;
+	uint32_t true_branch; //never complemented
+	uint32_t false_branch;
+};
+bool SaveModel(const string& path, const Graph* G, const vector<string>& names, vector<ROBDD>& roots); //G may be NULL to save results only
+class ModelFile //read-only mapping of a model file, the arrays point straight into it
+{
+public:
+	ModelFile();
+	~ModelFile();
+	bool Open(const string& path); //false if the file is missing or malformed, see Error
+	void Close();
+	string Error();
+	int NumVars() { return header->num_vars; }
+	int NumRoots() { return header->num_roots; }
+	int NumVertices() { return header->num_vertices; }
+	int NumEdges() { return header->num_edges; }
+	const int32_t* Order() { return order; }
+	const int32_t* Values() { return values; } //value of each vertex
+	const int32_t* Offsets() { return offsets; } //edges of vertex i are Targets()[Offsets()[i]..Offsets()[i+1]-1]
+	const int32_t* Targets() { return targets; }
+	vector<string> Names();
+	vector<ROBDD> Roots(); //applies the stored variable order, then hash-conses the table into the manager
+	void LoadGraph(Graph& G); //copies the CSR arrays, O(V+E)
+private:
+	const char* data;
+	size_t size;
+#ifdef _WIN32
+	void* file;
+	void* mapping;
+#endif
+	string error;
+	const ModelHeader* header;
+	const int32_t* order;
+	const ModelNode* nodes;
+	const uint32_t* roots;
+	const char* names;
+	const int32_t* values;
+	const int32_t* offsets;
+	const int32_t* targets;
+	bool Fail(const string& message);
+	bool Validate();
+};
@@ -0,0 +1,185 @@
+#include "Models.h"
+#include <cstdlib>
+#include <unordered_map>
+
+static void Label(Model& model, const string& symbol) //starts an empty label
+{
+	model.symbols.push_back(symbol);
+	model.labels.push_back(vector<int>());
+}
+
+void CounterModel(int bits, Model& model)
+{
+	model.name = "counter";
+	model.size = bits;
+	int states = 1 << bits;
+	for (int i = 0; i < states; i++) model.G.AddNode(i);
+	vector<int> sources, targets;
+	for (int i = 0; i < states; i++)
+	{
+		sources.push_back(i);
+		targets.push_back((i + 1) % states);
+		sources.push_back(i);
+		targets.push_back(0);
+	}
+	model.G.SetEdges(sources, targets);
+	Label(model, "zero");
+	Label(model, "max");
+	Label(model, "odd");
+	model.labels[0].push_back(0);
+	model.labels[1].push_back(states - 1);
+	for (int i = 1; i < states; i += 2) model.labels[2].push_back(i);
+	model.formulas.push_back("AG EF zero");
+	model.formulas.push_back("EG !max");
+	model.formulas.push_back("AF max");
+	model.formulas.push_back("E[!max U max]");
+	model.formulas.push_back("AG (odd -> AX !odd)");
+}
+
+void TokenRingModel(int processes, Model& model)
+{ //vertex token * 2^processes + waiting, bit i of waiting set while process i waits
+	model.name = "token_ring";
+	model.size = processes;
+	int masks = 1 << processes, states = processes * masks;
+	for (int i = 0; i < states; i++) model.G.AddNode(i);
+	vector<int> sources, targets;
+	for (int token = 0; token < processes; token++)
+	{
+		for (int waiting = 0; waiting < masks; waiting++)
+		{
+			int state = token * masks + waiting;
+			for (int i = 0; i < processes; i++) //a process asks
+			{
+				if (waiting >> i & 1) continue;
+				sources.push_back(state);
+				targets.push_back(token * masks + (waiting | 1 << i));
+			}
+			sources.push_back(state); //the holder is served if it waits, then the token moves on
+			targets.push_back((token + 1) % processes * masks + (waiting & ~(1 << token)));
+		}
+	}
+	model.G.SetEdges(sources, targets);
+	Label(model, "w0");
+	Label(model, "t0");
+	Label(model, "all");
+	for (int i = 0; i < states; i++)
+	{
+		if (i & 1) model.labels[0].push_back(i);
+		if (i < masks) model.labels[1].push_back(i);
+		if (i % masks == masks - 1) model.labels[2].push_back(i);
+	}
+	model.formulas.push_back("AG (w0 -> AF !w0)");
+	model.formulas.push_back("EF all");
+	model.formulas.push_back("AG EF t0");
+	model.formulas.push_back("EG w0");
+	model.formulas.push_back("E[!t0 U (w0 & t0)]");
+}
+
+void PhilosophersModel(int philosophers, Model& model)
+{ //states reachable from everyone thinking, digit i of the code in base 3 is philosopher i: 0 thinking, 1 hungry, 2 eating
+	model.name = "philosophers";
+	model.size = philosophers;
+	vector<int> power(philosophers + 1, 1);
+	for (int i = 1; i <= philosophers; i++) power[i] = power[i - 1] * 3;
+	unordered_map<int, int> index; //code to vertex
+	vector<int> codes(1, 0), sources, targets;
+	index[0] = 0;
+	for (int head = 0; head < codes.size(); head++)
+	{
+		int code = codes[head];
+		for (int i = 0; i < philosophers; i++)
+		{
+			int state = code / power[i] % 3;
+			int left = code / power[(i + philosophers - 1) % philosophers] % 3, right = code / power[(i + 1) % philosophers] % 3;
+			if (state == 1 && (left == 2 || right == 2)) continue; //a fork is taken
+			int next = code + (state == 2 ? -2 : 1) * power[i];
+			if (index.count(next) == 0)
+			{
+				index[next] = codes.size();
+				codes.push_back(next);
+			}
+			sources.push_back(head);
+			targets.push_back(index[next]);
+		}
+	}
+	for (int i = 0; i < codes.size(); i++) model.G.AddNode(codes[i]);
+	model.G.SetEdges(sources, targets);
+	Label(model, "eat0");
+	Label(model, "eat1");
+	Label(model, "hungry0");
+	for (int i = 0; i < codes.size(); i++)
+	{
+		if (codes[i] % 3 == 2) model.labels[0].push_back(i);
+		if (codes[i] / 3 % 3 == 2) model.labels[1].push_back(i);
+		if (codes[i] % 3 == 1) model.labels[2].push_back(i);
+	}
+	model.formulas.push_back("AG (hungry0 -> AF eat0)");
+	model.formulas.push_back("EF (eat0 & eat1)");
+	model.formulas.push_back("AG EF eat0");
+	model.formulas.push_back("EG !eat0");
+	model.formulas.push_back("AG !(eat0 & eat1)");
+}
+
+void RandomModel(int nodes, int degree, unsigned seed, Model& model)
+{
+	model.name = "random";
+	model.size = nodes;
+	srand(seed);
+	for (int i = 0; i < nodes; i++) model.G.AddNode(0);
+	vector<int> sources, targets;
+	for (int i = 0; i < nodes; i++)
+	{
+		for (int j = 0; j < degree; j++) sources.push_back(i);
+		targets.push_back((i + 1) % nodes);
+		for (int j = 1; j < degree; j++) targets.push_back(rand() % nodes);
+	}
+	model.G.SetEdges(sources, targets);
+	Label(model, "p");
+	Label(model, "q");
+	for (int i = 0; i < nodes; i++)
+	{
+		if (rand() % 10 < 7) model.labels[0].push_back(i);
+		if (rand() % 50 == 0) model.labels[1].push_back(i);
+	}
+	model.formulas.push_back("EX p");
+	model.formulas.push_back("EG p");
+	model.formulas.push_back("E[p U q]");
+	model.formulas.push_back("AG (p -> AF q)");
+	model.formulas.push_back("AG EF q");
+}
+
+void GridModel(int width, int height, Model& model)
+{ //vertex y * width + x
+	model.name = "grid";
+	model.size = width;
+	for (int i = 0; i < width * height; i++) model.G.AddNode(i);
+	vector<int> sources, targets;
+	for (int y = 0; y < height; y++)
+	{
+		for (int x = 0; x < width; x++)
+		{
+			sources.push_back(y * width + x);
+			targets.push_back(y * width + (x + 1) % width);
+			sources.push_back(y * width + x);
+			targets.push_back((y + 1) % height * width + x);
+		}
+	}
+	model.G.SetEdges(sources, targets);
+	Label(model, "origin");
+	Label(model, "left");
+	Label(model, "diag");
+	for (int y = 0; y < height; y++)
+	{
+		for (int x = 0; x < width; x++)
+		{
+			if (x == 0 && y == 0) model.labels[0].push_back(y * width + x);
+			if (x == 0) model.labels[1].push_back(y * width + x);
+			if (x == y) model.labels[2].push_back(y * width + x);
+		}
+	}
+	model.formulas.push_back("AG EF origin");
+	model.formulas.push_back("EG !origin");
+	model.formulas.push_back("AF left");
+	model.formulas.push_back("E[!diag U origin]");
+	model.formulas.push_back("AG (origin -> EX left)");
+}
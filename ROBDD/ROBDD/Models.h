@@ -0,0 +1,19 @@
+#pragma once
+#include<vector>
+#include<string>
+#include"Graph.h"
+using namespace std;
+struct Model //an explicit state graph, its labelling and the formulas it is usually checked against
+{
+	string name;
+	int size; //the parameter it was generated with
+	Graph G;
+	vector<string> symbols;
+	vector<vector<int> > labels; //vertices where each symbol holds
+	vector<string> formulas;
+};
+void CounterModel(int bits, Model& model); //increments modulo 2^bits, or resets to 0
+void TokenRingModel(int processes, Model& model); //processes ask for a token that travels the ring and serves them
+void PhilosophersModel(int philosophers, Model& model); //think, get hungry, eat when neither neighbour eats
+void RandomModel(int nodes, int degree, unsigned seed, Model& model); //a ring plus degree - 1 random edges per node, p holds at 70% of the nodes, q at 2%
+void GridModel(int width, int height, Model& model); //a torus, moves go right or down
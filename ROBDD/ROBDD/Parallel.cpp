@@ -0,0 +1,180 @@
+#include "Parallel.h"
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+
+struct WorkerQueue //owner pushes and pops at the back, thieves take from the front
+{
+	mutex lock;
+	deque<Task*> tasks;
+};
+
+struct Scheduler
+{
+	vector<WorkerQueue*> queues;
+	vector<thread*> threads;
+	int spawn_cutoff;
+	atomic<int> active; //nesting count of parallel sections
+	atomic<bool> stopping;
+	mutex sleep_mutex;
+	condition_variable wake;
+};
+
+static Scheduler* NewScheduler()
+{
+	Scheduler* pool = new Scheduler;
+	pool->spawn_cutoff = 8;
+	pool->active = 0;
+	pool->stopping = false;
+	return pool;
+}
+
+static Scheduler& Pool()
+{
+	static Scheduler* pool = NewScheduler(); //never destroyed, workers may still be asleep at exit
+	return *pool;
+}
+
+static thread_local int worker_id = -1;
+
+static Task* Steal(unsigned& seed)
+{
+	vector<WorkerQueue*>& queues = Pool().queues;
+	int count = queues.size();
+	for (int tries = 0; tries < count; tries++)
+	{
+		seed = seed * 1103515245 + 12345;
+		int victim = (seed >> 16) % count;
+		if (victim == worker_id) continue;
+		lock_guard<mutex> guard(queues[victim]->lock);
+		if (queues[victim]->tasks.empty()) continue;
+		Task* task = queues[victim]->tasks.front();
+		queues[victim]->tasks.pop_front();
+		return task;
+	}
+	return NULL;
+}
+
+static void Execute(Task* task)
+{
+	task->run(task);
+	task->done.store(true, memory_order_release);
+}
+
+static void WorkerLoop(int id)
+{
+	Scheduler& pool = Pool();
+	worker_id = id;
+	unsigned seed = id;
+	while (1)
+	{
+		{
+			unique_lock<mutex> guard(pool.sleep_mutex);
+			pool.wake.wait(guard, [&pool] { return pool.active > 0 || pool.stopping; });
+		}
+		if (pool.stopping) return;
+		int idle = 0;
+		while (pool.active > 0)
+		{
+			Task* task = Steal(seed);
+			if (task != NULL)
+			{
+				Execute(task);
+				idle = 0;
+			}
+			else if (++idle < 64) this_thread::yield();
+			else this_thread::sleep_for(chrono::microseconds(50)); //nothing to steal for a while, stop burning the core
+		}
+	}
+}
+
+void SetWorkers(int count)
+{
+	Scheduler& pool = Pool();
+	if (count < 1) count = 1;
+	pool.stopping = true;
+	{
+		lock_guard<mutex> guard(pool.sleep_mutex);
+	}
+	pool.wake.notify_all();
+	for (int i = 0; i < pool.threads.size(); i++)
+	{
+		pool.threads[i]->join();
+		delete pool.threads[i];
+	}
+	pool.threads.clear();
+	for (int i = 0; i < pool.queues.size(); i++) delete pool.queues[i];
+	pool.queues.clear();
+	pool.stopping = false;
+	worker_id = 0; //the calling thread is worker 0
+	for (int i = 0; i < count; i++) pool.queues.push_back(new WorkerQueue);
+	for (int i = 1; i < count; i++) pool.threads.push_back(new thread(WorkerLoop, i));
+}
+
+int Workers()
+{
+	return Pool().queues.empty() ? 1 : Pool().queues.size();
+}
+
+void SetSpawnCutoff(int depth)
+{
+	Pool().spawn_cutoff = depth;
+}
+
+int SpawnCutoff()
+{
+	return Pool().spawn_cutoff;
+}
+
+bool CanSpawn(int depth)
+{
+	return depth < Pool().spawn_cutoff && worker_id >= 0 && Pool().active > 0;
+}
+
+void Spawn(Task& task)
+{
+	task.done.store(false, memory_order_relaxed);
+	WorkerQueue& queue = *Pool().queues[worker_id];
+	lock_guard<mutex> guard(queue.lock);
+	queue.tasks.push_back(&task);
+}
+
+void Sync(Task& task)
+{
+	{
+		WorkerQueue& queue = *Pool().queues[worker_id];
+		unique_lock<mutex> guard(queue.lock);
+		if (!queue.tasks.empty() && queue.tasks.back() == &task) //nobody took it
+		{
+			queue.tasks.pop_back();
+			guard.unlock();
+			task.run(&task);
+			return;
+		}
+	}
+	unsigned seed = (unsigned)(size_t)&task;
+	while (!task.done.load(memory_order_acquire)) //stolen, work on something else meanwhile
+	{
+		Task* other = Steal(seed);
+		if (other != NULL) Execute(other);
+		else this_thread::yield();
+	}
+}
+
+void BeginParallel()
+{
+	Scheduler& pool = Pool();
+	if (pool.active++ > 0) return;
+	{
+		lock_guard<mutex> guard(pool.sleep_mutex);
+	}
+	pool.wake.notify_all();
+}
+
+void EndParallel()
+{
+	Pool().active--;
+}
@@ -0,0 +1,17 @@
+#pragma once
+#include<atomic>
+using namespace std;
+struct Task //a unit of work other threads may steal, lives on the stack of the thread that spawned it
+{
+	void(*run)(Task* task);
+	atomic<bool> done;
+};
+void SetWorkers(int count); //threads taking part in parallel operations, the calling thread included
+int Workers();
+void SetSpawnCutoff(int depth); //recursions deeper than this never spawn tasks
+int SpawnCutoff();
+bool CanSpawn(int depth); //true inside a parallel section, on a worker, above the cutoff
+void Spawn(Task& task);
+void Sync(Task& task); //runs the task here unless it was stolen, then helps out until it is done
+void BeginParallel(); //wakes the other workers
+void EndParallel(); //lets them sleep again
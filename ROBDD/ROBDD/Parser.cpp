@@ -0,0 +1,222 @@
+#include "Parser.h"
+#include <cctype>
+
+FormulaParser::FormulaParser(FormulaDAG& dag, const unordered_map<string, int>& symbols) : dag(dag), symbols(symbols)
+{
+	text = NULL;
+	pos = 0;
+}
+
+void FormulaParser::Next()
+{
+	const string& s = *text;
+	while (pos < s.length() && isspace((unsigned char)s[pos])) pos++;
+	token.start = pos;
+	token.length = 1;
+	if (pos == s.length())
+	{
+		token.type = TOKEN_END;
+		token.length = 0;
+		return;
+	}
+	char c = s[pos];
+	if (isalpha((unsigned char)c) || c == '_')
+	{
+		while (pos < s.length() && (isalnum((unsigned char)s[pos]) || s[pos] == '_')) pos++;
+		token.type = TOKEN_NAME;
+		token.length = pos - token.start;
+		return;
+	}
+	pos++;
+	switch (c)
+	{
+	case '(': token.type = TOKEN_LPAREN; break;
+	case ')': token.type = TOKEN_RPAREN; break;
+	case '[': token.type = TOKEN_LBRACKET; break;
+	case ']': token.type = TOKEN_RBRACKET; break;
+	case ',': token.type = TOKEN_COMMA; break;
+	case '!':
+	case '~': token.type = TOKEN_NOT; break;
+	case '&':
+		token.type = TOKEN_AND;
+		if (pos < s.length() && s[pos] == '&') pos++;
+		break;
+	case '|':
+		token.type = TOKEN_OR;
+		if (pos < s.length() && s[pos] == '|') pos++;
+		break;
+	case '-':
+		token.type = TOKEN_ERROR;
+		if (pos < s.length() && s[pos] == '>')
+		{
+			token.type = TOKEN_IMPLY;
+			pos++;
+		}
+		break;
+	default: token.type = TOKEN_ERROR;
+	}
+	token.length = pos - token.start;
+}
+
+bool FormulaParser::Is(const char* word)
+{
+	return token.type == TOKEN_NAME && text->compare(token.start, token.length, word) == 0;
+}
+
+int FormulaParser::Fail(const string& message)
+{
+	return Fail(message, token.start);
+}
+
+int FormulaParser::Fail(const string& message, int start)
+{
+	if (error.empty()) error = message + " at column " + to_string(start + 1);
+	return -1;
+}
+
+bool FormulaParser::Expect(int type, const char* what)
+{
+	if (token.type != type)
+	{
+		Fail(string("expected ") + what);
+		return false;
+	}
+	Next();
+	return true;
+}
+
+int FormulaParser::Parse(const string& text)
+{
+	this->text = &text;
+	pos = 0;
+	error.clear();
+	Next();
+	int ret = Implication();
+	if (ret != -1 && token.type != TOKEN_END) return Fail("unexpected input");
+	return ret;
+}
+
+string FormulaParser::Error()
+{
+	return error;
+}
+
+int FormulaParser::Implication() //right associative, binds weakest
+{
+	int left = Disjunction();
+	if (left == -1 || token.type != TOKEN_IMPLY) return left;
+	Next();
+	int right = Implication();
+	if (right == -1) return -1;
+	return dag.Make(F_IMPLY, left, right);
+}
+
+int FormulaParser::Disjunction()
+{
+	int left = Conjunction();
+	while (left != -1 && token.type == TOKEN_OR)
+	{
+		Next();
+		int right = Conjunction();
+		if (right == -1) return -1;
+		left = dag.Make(F_OR, left, right);
+	}
+	return left;
+}
+
+int FormulaParser::Conjunction()
+{
+	int left = Unary();
+	while (left != -1 && token.type == TOKEN_AND)
+	{
+		Next();
+		int right = Unary();
+		if (right == -1) return -1;
+		left = dag.Make(F_AND, left, right);
+	}
+	return left;
+}
+
+static const char* const UnaryNames[] = { "EX", "AX", "EF", "AF", "EG", "AG" };
+static const int UnaryOps[] = { F_EX, F_AX, F_EF, F_AF, F_EG, F_AG };
+
+int FormulaParser::Unary()
+{
+	if (token.type == TOKEN_NOT)
+	{
+		Next();
+		int operand = Unary();
+		return operand == -1 ? -1 : dag.Make(F_NOT, operand);
+	}
+	if (token.type == TOKEN_LPAREN)
+	{
+		Next();
+		int ret = Implication();
+		if (ret == -1 || !Expect(TOKEN_RPAREN, "')'")) return -1;
+		return ret;
+	}
+	if (token.type != TOKEN_NAME) return Fail("expected a formula");
+	name.assign(*text, token.start, token.length);
+	int start = token.start;
+	Next();
+	if (token.type == TOKEN_LBRACKET && (name == "E" || name == "A")) //E[p U q] and A[p U q]
+	{
+		int op = name == "E" ? F_EU : F_AU; //name is reused by the operands
+		Next();
+		int left = Implication();
+		if (left == -1) return -1;
+		if (!Is("U")) return Fail("expected 'U'");
+		Next();
+		int right = Implication();
+		if (right == -1 || !Expect(TOKEN_RBRACKET, "']'")) return -1;
+		return dag.Make(op, left, right);
+	}
+	if (token.type == TOKEN_LPAREN)
+	{
+		string op = name;
+		for (int i = 0; i < op.length(); i++) op[i] = tolower((unsigned char)op[i]);
+		if (op != "and" && op != "or" && op != "imply" && op != "not" && op != "eu" && op != "ex" && op != "ax"
+			&& op != "ef" && op != "af" && op != "eg" && op != "ag") return Fail("unknown operator " + name, start);
+		return Call(op);
+	}
+	for (int i = 0; i < 6; i++) //prefix temporal operators, e.g. EG !p
+	{
+		if (name != UnaryNames[i] || symbols.count(name)) continue;
+		int operand = Unary();
+		return operand == -1 ? -1 : dag.Make(UnaryOps[i], operand);
+	}
+	if (name == "true" || name == "TRUE") return dag.True();
+	if (name == "false" || name == "FALSE") return dag.Make(F_NOT, dag.True());
+	unordered_map<string, int>::const_iterator it = symbols.find(name);
+	if (it == symbols.end()) return Fail("unknown symbol " + name, start);
+	return dag.Atom(it->second);
+}
+
+int FormulaParser::Call(const string& op)
+{
+	Next(); //the '('
+	int left = Implication();
+	if (left == -1) return -1;
+	int right = -1;
+	bool binary = op == "and" || op == "or" || op == "imply" || op == "eu";
+	if (binary)
+	{
+		if (!Expect(TOKEN_COMMA, "','")) return -1;
+		right = Implication();
+		if (right == -1) return -1;
+	}
+	if (!Expect(TOKEN_RPAREN, "')'")) return -1;
+	if (op == "and") return dag.Make(F_AND, left, right);
+	if (op == "or") return dag.Make(F_OR, left, right);
+	if (op == "imply") return dag.Make(F_IMPLY, left, right);
+	if (op == "eu") return dag.Make(F_EU, left, right);
+	if (op == "not") return dag.Make(F_NOT, left);
+	for (int i = 0; i < 6; i++)
+	{
+		string lower = UnaryNames[i];
+		lower[0] = tolower(lower[0]);
+		lower[1] = tolower(lower[1]);
+		if (op == lower) return dag.Make(UnaryOps[i], left);
+	}
+	return Fail("unknown operator " + op);
+}
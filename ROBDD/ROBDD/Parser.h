@@ -0,0 +1,50 @@
+#pragma once
+#include<string>
+#include<unordered_map>
+#include"Formula.h"
+using namespace std;
+enum TokenType
+{
+	TOKEN_END,
+	TOKEN_NAME,
+	TOKEN_LPAREN,
+	TOKEN_RPAREN,
+	TOKEN_LBRACKET,
+	TOKEN_RBRACKET,
+	TOKEN_COMMA,
+	TOKEN_NOT, //! or ~
+	TOKEN_AND, //& or &&
+	TOKEN_OR, //| or ||
+	TOKEN_IMPLY, //->
+	TOKEN_ERROR
+};
+struct Token
+{
+	int type;
+	int start, length; //position in the text, nothing is copied
+};
+class FormulaParser //one pass over the text, nodes go straight into the DAG
+{
+public:
+	FormulaParser(FormulaDAG& dag, const unordered_map<string, int>& symbols);
+	int Parse(const string& text); //the formula's node, -1 on a syntax error
+	string Error(); //what went wrong in the last Parse, and where
+private:
+	FormulaDAG& dag;
+	const unordered_map<string, int>& symbols;
+	const string* text;
+	int pos;
+	Token token; //the current token
+	string error;
+	string name; //reused for symbol lookups
+	void Next();
+	bool Is(const char* word); //the current token is this name
+	bool Expect(int type, const char* what);
+	int Fail(const string& message);
+	int Fail(const string& message, int start); //for a token already consumed
+	int Implication();
+	int Disjunction();
+	int Conjunction();
+	int Unary();
+	int Call(const string& op); //prefix form, e.g. and(p,q) or EU(p,q)
+};
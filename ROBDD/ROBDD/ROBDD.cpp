@@ -1,848 +1,1478 @@
-﻿#include "ROBDD.h"
-#include "MathFunc.h"
-#include <math.h>
-#include <map>
-#include <iostream>
-using namespace std;
-
-void ROBDD::ConvertFromGraph(Graph graph)
-{
-	if (!nodes.empty()) nodes.clear();
-	root = new ROBDDNode; //root
-	root->value.successor.true_branch = root->value.successor.false_branch = NULL;
-	root->label = 0;
-	nodes.push_back(root);
-	int depth = ceil(log2(graph.num_nodes));
-	ROBDDNode* current;
-	for (int i = 0; i < graph.num_nodes; i++)
-	{
-		if (graph.nodes[i]->value == 0) continue;
-		vector<bool> path = IntToBinVec(i, depth);
-		current = root;
-		for (int j = 0; j < path.size(); j++)
-		{
-			if (path[j] == true)  //walk to true branch
-			{
-				if (current->value.successor.true_branch == NULL) //create a new node
-				{
-					ROBDDNode* NewNode = new ROBDDNode;
-					current->label = j;
-					current->value.successor.true_branch = NewNode;
-					NewNode->label = j + 1;
-					NewNode->value.successor.true_branch = NULL;
-					NewNode->value.successor.false_branch = NULL;
-					nodes.push_back(NewNode);
-					current = NewNode;
-				}
-				else //move down current
-				{
-					current = current->value.successor.true_branch;
-				}
-			}
-			else //walk to false branch
-			{
-				if (current->value.successor.false_branch == NULL) //create a new node
-				{
-					ROBDDNode* NewNode = new ROBDDNode;
-					current->label = j;
-					current->value.successor.false_branch = NewNode;
-					NewNode->value.successor.true_branch = NULL;
-					NewNode->value.successor.false_branch = NULL;
-					NewNode->label = j + 1;
-					nodes.push_back(NewNode);
-					current = NewNode;
-				}
-				else //move down current
-				{
-					current = current->value.successor.false_branch;
-				}
-			}
-		}
-		current->label = -1; //convert the last node to leaf
-		current->value.value = 1;
-	}
-	vector<ROBDDNode*> NodeToAdd;
-	for (int i = 0; i < nodes.size(); i++) //assign false leaves
-	{
-		if (nodes[i]->label != -1 && nodes[i]->value.successor.true_branch == NULL)
-		{
-			ROBDDNode* NewNode = new ROBDDNode;
-			NewNode->label = -1;
-			NewNode->value.value = 0;
-			nodes[i]->value.successor.true_branch = NewNode;
-			NodeToAdd.push_back(NewNode);
-		}
-		if (nodes[i]->label != -1 && nodes[i]->value.successor.false_branch == NULL)
-		{
-			ROBDDNode* NewNode = new ROBDDNode;
-			NewNode->label = -1;
-			NewNode->value.value = 0;
-			nodes[i]->value.successor.false_branch = NewNode;
-			NodeToAdd.push_back(NewNode);
-		}
-	}
-	for (int i = 0; i < NodeToAdd.size(); i++) nodes.push_back(NodeToAdd[i]);
-	Simplify();
-}
-
-void ROBDD::FromTrueValueVector(vector<int> TrueValues)
-{
-	if (!nodes.empty()) nodes.clear();
-	root = new ROBDDNode; //root
-	root->value.successor.true_branch = root->value.successor.false_branch = NULL;
-	root->label = 0;
-	nodes.push_back(root);
-	int max = 0;
-	for (int i = 0; i < TrueValues.size(); i++)
-	{
-		if (TrueValues[i] > max) max = TrueValues[i];
-	}
-	int depth = ceil(log2(max + 1));
-	ROBDDNode* current;
-	for (int i = 0; i < TrueValues.size(); i++)
-	{
-		vector<bool> path = IntToBinVec(TrueValues[i], depth);
-		current = root;
-		for (int j = 0; j < path.size(); j++)
-		{
-			if (path[j] == true)  //walk to true branch
-			{
-				if (current->value.successor.true_branch == NULL) //create a new node
-				{
-					ROBDDNode* NewNode = new ROBDDNode;
-					current->label = j;
-					current->value.successor.true_branch = NewNode;
-					NewNode->label = j + 1;
-					NewNode->value.successor.true_branch = NULL;
-					NewNode->value.successor.false_branch = NULL;
-					nodes.push_back(NewNode);
-					current = NewNode;
-				}
-				else //move down current
-				{
-					current = current->value.successor.true_branch;
-				}
-			}
-			else //walk to false branch
-			{
-				if (current->value.successor.false_branch == NULL) //create a new node
-				{
-					ROBDDNode* NewNode = new ROBDDNode;
-					current->label = j;
-					current->value.successor.false_branch = NewNode;
-					NewNode->value.successor.true_branch = NULL;
-					NewNode->value.successor.false_branch = NULL;
-					NewNode->label = j + 1;
-					nodes.push_back(NewNode);
-					current = NewNode;
-				}
-				else //move down current
-				{
-					current = current->value.successor.false_branch;
-				}
-			}
-		}
-		current->label = -1; //convert the last node to leaf
-		current->value.value = 1;
-	}
-	vector<ROBDDNode*> NodeToAdd;
-	for (int i = 0; i < nodes.size(); i++) //assign false leaves
-	{
-		if (nodes[i]->label != -1 && nodes[i]->value.successor.true_branch == NULL)
-		{
-			ROBDDNode* NewNode = new ROBDDNode;
-			NewNode->label = -1;
-			NewNode->value.value = 0;
-			nodes[i]->value.successor.true_branch = NewNode;
-			NodeToAdd.push_back(NewNode);
-		}
-		if (nodes[i]->label != -1 && nodes[i]->value.successor.false_branch == NULL)
-		{
-			ROBDDNode* NewNode = new ROBDDNode;
-			NewNode->label = -1;
-			NewNode->value.value = 0;
-			nodes[i]->value.successor.false_branch = NewNode;
-			NodeToAdd.push_back(NewNode);
-		}
-	}
-	for (int i = 0; i < NodeToAdd.size(); i++) nodes.push_back(NodeToAdd[i]);
-	Simplify();
-}
-
-void ROBDD::Simplify() //label nannot be less than -1
-{
-	int flag;
-	do
-	{
-		flag = 0;
-		for (int i = 0; i < nodes.size(); i++)
-		{
-			if (nodes[i]->label != -1 && Equal(nodes[i]->value.successor.true_branch, nodes[i]->value.successor.false_branch))
-			{
-				nodes[i]->label = nodes[i]->value.successor.true_branch->label;
-				if (nodes[i]->value.successor.true_branch->label == -1)
-					nodes[i]->value.value = nodes[i]->value.successor.true_branch->value.value;
-				else
-				{
-					nodes[i]->value.successor.true_branch = nodes[i]->value.successor.false_branch->value.successor.true_branch;
-					nodes[i]->value.successor.false_branch = nodes[i]->value.successor.false_branch->value.successor.false_branch;
-				}
-				flag = 1;
-			}
-		}
-		nodes = NodeVector(root);
-		for (int i = 0; i < nodes.size(); i++) //merge
-		{
-			for (int j = i + 1; j < nodes.size(); j++)
-			{
-				if (nodes[i]->label == -1 || nodes[j]->label == -1) continue;
-				if (nodes[j]->value.successor.false_branch != nodes[i]->value.successor.false_branch&&Equal(nodes[j]->value.successor.false_branch, nodes[i]->value.successor.false_branch))
-				{
-					flag = 1;
-					for (vector<ROBDDNode*>::iterator ite = nodes.begin(); ite != nodes.end(); ite++)
-					{
-						if (*ite == nodes[j]->value.successor.false_branch)
-						{
-							nodes[j]->value.successor.false_branch = nodes[i]->value.successor.false_branch;
-							goto erase;
-						}
-					}
-				}
-				if (nodes[j]->value.successor.false_branch != nodes[i]->value.successor.true_branch&&Equal(nodes[j]->value.successor.false_branch, nodes[i]->value.successor.true_branch))
-				{
-					flag = 1;
-					for (vector<ROBDDNode*>::iterator ite = nodes.begin(); ite != nodes.end(); ite++)
-					{
-						if (*ite == nodes[j]->value.successor.false_branch)
-						{
-							nodes[j]->value.successor.false_branch = nodes[i]->value.successor.true_branch;
-							goto erase;
-						}
-					}
-				}
-				if (nodes[j]->value.successor.true_branch != nodes[i]->value.successor.false_branch&&Equal(nodes[j]->value.successor.true_branch, nodes[i]->value.successor.false_branch))
-				{
-					flag = 1;
-					for (vector<ROBDDNode*>::iterator ite = nodes.begin(); ite != nodes.end(); ite++)
-					{
-						if (*ite == nodes[j]->value.successor.true_branch)
-						{
-							nodes[j]->value.successor.true_branch = nodes[i]->value.successor.false_branch;
-							goto erase;
-						}
-					}
-				}
-				if (nodes[j]->value.successor.true_branch != nodes[i]->value.successor.true_branch&&Equal(nodes[j]->value.successor.true_branch, nodes[i]->value.successor.true_branch))
-				{
-					flag = 1;
-					for (vector<ROBDDNode*>::iterator ite = nodes.begin(); ite != nodes.end(); ite++)
-					{
-						if (*ite == nodes[j]->value.successor.true_branch)
-						{
-							nodes[j]->value.successor.true_branch = nodes[i]->value.successor.true_branch;
-							goto erase;
-						}
-					}
-				}
-			}
-		}
-	erase:;
-		nodes = NodeVector(root);
-	} while (flag);
-}
-
-void ROBDD::Print() //label cannot be less than -1
-{
-	map<ROBDDNode*, int> ID;
-	for (int i = 0; i < nodes.size(); i++) ID[nodes[i]] = i;
-	for (int i = 0; i < nodes.size(); i++)
-	{
-		if (nodes[i]->label != -1)
-		{
-			if (nodes[i]->value.successor.false_branch->label != -1)
-				cout << ID[nodes[i]] << "(tests x" << nodes[i]->label << ")" << "  ----False---->  " << ID[nodes[i]->value.successor.false_branch] << endl;
-			else
-				if (nodes[i]->value.successor.false_branch->value.value == 1)
-					cout << ID[nodes[i]] << "(tests x" << nodes[i]->label << ")" << "  ----False---->  " << ID[nodes[i]->value.successor.false_branch] << "(True)" << endl;
-				else
-					cout << ID[nodes[i]] << "(tests x" << nodes[i]->label << ")" << "  ----False---->  " << ID[nodes[i]->value.successor.false_branch] << "(False)" << endl;
-			if (nodes[i]->value.successor.true_branch->label != -1)
-				cout << ID[nodes[i]] << "(tests x" << nodes[i]->label << ")" << "  ----True---->  " << ID[nodes[i]->value.successor.true_branch] << endl;
-			else
-				if (nodes[i]->value.successor.true_branch->value.value == 1)
-					cout << ID[nodes[i]] << "(tests x" << nodes[i]->label << ")" << "  ----True---->  " << ID[nodes[i]->value.successor.true_branch] << "(True)" << endl;
-				else
-					cout << ID[nodes[i]] << "(tests x" << nodes[i]->label << ")" << "  ----True---->  " << ID[nodes[i]->value.successor.true_branch] << "(False)" << endl;
-		}
-		else
-		{
-			if (nodes[i]->value.value == 1)
-				cout << ID[nodes[i]] << "  stands for True" << endl;
-			else
-				cout << ID[nodes[i]] << "  stands for False" << endl;
-		}
-	}
-}
-
-ROBDD ROBDD::CloneROBDD()
-{
-	ROBDD ret;
-	ret.root = Clone(root);
-	ret.nodes = NodeVector(ret.root);
-	ret.Simplify();
-	return ret;
-}
-
-bool ROBDD::Walk(int path, int pathlen)
-{
-	vector<bool> _path = IntToBinVec(path, pathlen);
-	ROBDDNode* current = root;
-	for (int i = 0; i < _path.size(); i++)
-	{
-		if (i != current->label) continue;
-		if (_path[i]) current = current->value.successor.true_branch;
-		else current = current->value.successor.false_branch;
-	}
-	if (current->value.value == 0) return false;
-	return true;
-}
-
-vector<ROBDDNode*> NodeVector(ROBDDNode * StartVector)
-{
-	vector<ROBDDNode*> ret, TrueBranch, FalseBranch;
-	ret.push_back(StartVector);
-	if (StartVector->label >= 0)
-	{
-		TrueBranch = NodeVector(StartVector->value.successor.true_branch);
-		FalseBranch = NodeVector(StartVector->value.successor.false_branch);
-		for (int i = 0; i < TrueBranch.size(); i++)
-		{
-			vector<ROBDDNode*>::iterator it;
-			it = find(ret.begin(), ret.end(), TrueBranch[i]);
-			if (it != ret.end()) continue;
-			ret.push_back(TrueBranch[i]);
-		}
-		for (int i = 0; i < FalseBranch.size(); i++)
-		{
-			vector<ROBDDNode*>::iterator it;
-			it = find(ret.begin(), ret.end(), FalseBranch[i]);
-			if (it != ret.end()) continue;
-			ret.push_back(FalseBranch[i]);
-		}
-	}
-	return ret;
-}
-
-bool Equal(ROBDDNode* node1, ROBDDNode* node2) //label cannot be less than -1
-{
-	if (node1->label == -1 && node2->label == -1)
-	{
-		if (node1->value.value == node2->value.value) return true;
-		else return false;
-	}
-	else if (node1->label == -1 || node2->label == -1) return false;
-	else return Equal(node1->value.successor.true_branch, node2->value.successor.true_branch) & Equal(node1->value.successor.false_branch, node2->value.successor.false_branch);
-}
-
-ROBDD AND(ROBDD robdd1, ROBDD robdd2)
-{
-	ROBDD cloned_left = robdd1.CloneROBDD();
-	ROBDD cloned_right = robdd2.CloneROBDD();
-	ROBDD robdd_false;
-	ROBDDNode* NewNode = new ROBDDNode;
-	NewNode->label = -1;
-	NewNode->value.value = 0;
-	robdd_false.nodes.push_back(NewNode);
-	robdd_false.root = NewNode;
-	if (cloned_left.nodes.size() == 1)
-	{
-		if (cloned_left.root->value.value == 1) return cloned_right;
-		else return robdd_false;
-	}
-	if (cloned_right.nodes.size() == 1)
-	{
-		if (cloned_right.root->value.value == 1) return cloned_left;
-		else return robdd_false;
-	}
-	if (robdd1.root->label == robdd2.root->label)
-	{
-		ROBDD TrueROBDD, FalseROBDD;
-		ROBDD cloned_left_left, cloned_left_right, cloned_right_left, cloned_right_right;
-		NewNode = Clone(cloned_left.root->value.successor.true_branch);
-		cloned_left_left.root = NewNode;
-		cloned_left_left.nodes = NodeVector(cloned_left_left.root);
-		NewNode = Clone(cloned_left.root->value.successor.false_branch);
-		cloned_left_right.root = NewNode;
-		cloned_left_right.nodes = NodeVector(cloned_left_right.root);
-		NewNode = Clone(cloned_right.root->value.successor.true_branch);
-		cloned_right_left.root = NewNode;
-		cloned_right_left.nodes = NodeVector(cloned_right_left.root);
-		NewNode = Clone(cloned_right.root->value.successor.false_branch);
-		cloned_right_right.root = NewNode;
-		cloned_right_right.nodes = NodeVector(cloned_right_right.root);
-		TrueROBDD = AND(cloned_left_left, cloned_right_left);
-		FalseROBDD = AND(cloned_left_right, cloned_right_right);
-		ROBDD ret;
-		ret.root = new ROBDDNode;
-		ret.root->label = robdd1.root->label;
-		ret.root->value.successor.true_branch = TrueROBDD.root;
-		ret.root->value.successor.false_branch = FalseROBDD.root;
-		ret.nodes = NodeVector(ret.root);
-		ret.Simplify();
-		return ret;
-	}
-	ROBDD ret;
-	if (!Contain(cloned_right.root, cloned_left.root->label))
-	{
-		ROBDD TrueROBDD, FalseROBDD;
-		ROBDD cloned_left_left, cloned_left_right;
-		NewNode = Clone(cloned_left.root->value.successor.true_branch);
-		cloned_left_left.root = NewNode;
-		cloned_left_left.nodes = NodeVector(cloned_left_left.root);
-		NewNode = Clone(cloned_left.root->value.successor.false_branch);
-		cloned_left_right.root = NewNode;
-		cloned_left_right.nodes = NodeVector(cloned_left_right.root);
-		TrueROBDD = AND(cloned_left_left, cloned_right);
-		FalseROBDD = AND(cloned_left_right, cloned_right);
-		ret.root = new ROBDDNode;
-		ret.root->label = robdd1.root->label;
-		ret.root->value.successor.true_branch = TrueROBDD.root;
-		ret.root->value.successor.false_branch = FalseROBDD.root;
-	}
-	else
-	{
-		ROBDD TrueROBDD, FalseROBDD;
-		ROBDD cloned_right_left, cloned_right_right;
-		NewNode = Clone(cloned_right.root->value.successor.true_branch);
-		cloned_right_left.root = NewNode;
-		cloned_right_left.nodes = NodeVector(cloned_right_left.root);
-		NewNode = Clone(cloned_right.root->value.successor.false_branch);
-		cloned_right_right.root = NewNode;
-		cloned_right_right.nodes = NodeVector(cloned_right_right.root);
-		TrueROBDD = AND(cloned_right_left, cloned_left);
-		FalseROBDD = AND(cloned_right_right, cloned_left);
-		ret.root = new ROBDDNode;
-		ret.root->label = robdd2.root->label;
-		ret.root->value.successor.true_branch = TrueROBDD.root;
-		ret.root->value.successor.false_branch = FalseROBDD.root;
-	}
-	ret.nodes = NodeVector(ret.root);
-	for (int i = 0; i < ret.nodes.size(); i++)
-	{
-		if (ret.nodes[i]->label == 0)
-		{
-			ret.root = ret.nodes[i];
-			break;
-		}
-	}
-	ret.nodes = NodeVector(ret.root);
-	ret.Simplify();
-	return ret;
-}
-
-ROBDD OR(ROBDD robdd1, ROBDD robdd2)
-{
-	ROBDD cloned_left = robdd1.CloneROBDD();
-	ROBDD cloned_right = robdd2.CloneROBDD();
-	ROBDD robdd_true;
-	ROBDDNode* NewNode = new ROBDDNode;
-	NewNode->label = -1;
-	NewNode->value.value = 1;
-	robdd_true.nodes.push_back(NewNode);
-	robdd_true.root = NewNode;
-	if (cloned_left.nodes.size() == 1)
-	{
-		if (cloned_left.root->value.value == 1) return robdd_true;
-		else return cloned_right;
-	}
-	if (cloned_right.nodes.size() == 1)
-	{
-		if (cloned_right.root->value.value == 1) return robdd_true;
-		else return cloned_left;
-	}
-	if (robdd1.root->label == robdd2.root->label)
-	{
-		ROBDD TrueROBDD, FalseROBDD;
-		ROBDD cloned_left_left, cloned_left_right, cloned_right_left, cloned_right_right;
-		NewNode = Clone(cloned_left.root->value.successor.true_branch);
-		cloned_left_left.root = NewNode;
-		cloned_left_left.nodes = NodeVector(cloned_left_left.root);
-		NewNode = Clone(cloned_left.root->value.successor.false_branch);
-		cloned_left_right.root = NewNode;
-		cloned_left_right.nodes = NodeVector(cloned_left_right.root);
-		NewNode = Clone(cloned_right.root->value.successor.true_branch);
-		cloned_right_left.root = NewNode;
-		cloned_right_left.nodes = NodeVector(cloned_right_left.root);
-		NewNode = Clone(cloned_right.root->value.successor.false_branch);
-		cloned_right_right.root = NewNode;
-		cloned_right_right.nodes = NodeVector(cloned_right_right.root);
-		TrueROBDD = OR(cloned_left_left, cloned_right_left);
-		FalseROBDD = OR(cloned_left_right, cloned_right_right);
-		ROBDD ret;
-		ret.root = new ROBDDNode;
-		ret.root->label = robdd1.root->label;
-		ret.root->value.successor.true_branch = TrueROBDD.root;
-		ret.root->value.successor.false_branch = FalseROBDD.root;
-		ret.nodes = NodeVector(ret.root);
-		ret.Simplify();
-		return ret;
-	}
-	ROBDD ret;
-	if (!Contain(cloned_right.root, cloned_left.root->label))
-	{
-		ROBDD TrueROBDD, FalseROBDD;
-		ROBDD cloned_left_left, cloned_left_right;
-		NewNode = Clone(cloned_left.root->value.successor.true_branch);
-		cloned_left_left.root = NewNode;
-		cloned_left_left.nodes = NodeVector(cloned_left_left.root);
-		NewNode = Clone(cloned_left.root->value.successor.false_branch);
-		cloned_left_right.root = NewNode;
-		cloned_left_right.nodes = NodeVector(cloned_left_right.root);
-		TrueROBDD = OR(cloned_left_left, cloned_right);
-		FalseROBDD = OR(cloned_left_right, cloned_right);
-		ret.root = new ROBDDNode;
-		ret.root->label = robdd1.root->label;
-		ret.root->value.successor.true_branch = TrueROBDD.root;
-		ret.root->value.successor.false_branch = FalseROBDD.root;
-	}
-	else
-	{
-		ROBDD TrueROBDD, FalseROBDD;
-		ROBDD cloned_right_left, cloned_right_right;
-		NewNode = Clone(cloned_right.root->value.successor.true_branch);
-		cloned_right_left.root = NewNode;
-		cloned_right_left.nodes = NodeVector(cloned_right_left.root);
-		NewNode = Clone(cloned_right.root->value.successor.false_branch);
-		cloned_right_right.root = NewNode;
-		cloned_right_right.nodes = NodeVector(cloned_right_right.root);
-		TrueROBDD = OR(cloned_right_left, cloned_left);
-		FalseROBDD = OR(cloned_right_right, cloned_left);
-		ret.root = new ROBDDNode;
-		ret.root->label = robdd2.root->label;
-		ret.root->value.successor.true_branch = TrueROBDD.root;
-		ret.root->value.successor.false_branch = FalseROBDD.root;
-	}
-	ret.nodes = NodeVector(ret.root);
-	for (int i = 0; i < ret.nodes.size(); i++)
-	{
-		if (ret.nodes[i]->label == 0)
-		{
-			ret.root = ret.nodes[i];
-			break;
-		}
-	}
-	ret.nodes = NodeVector(ret.root);
-	ret.Simplify();
-	return ret;
-}
-
-ROBDD IMPLY(ROBDD robdd1, ROBDD robdd2)
-{
-	ROBDD cloned_left = robdd1.CloneROBDD();
-	ROBDD cloned_right = robdd2.CloneROBDD();
-	ROBDD robdd_true;
-	ROBDDNode* NewNode = new ROBDDNode;
-	NewNode->label = -1;
-	NewNode->value.value = 1;
-	robdd_true.nodes.push_back(NewNode);
-	robdd_true.root = NewNode;
-	if (cloned_left.nodes.size() == 1)
-	{
-		if (cloned_left.root->value.value == 1) return cloned_right;
-		else return robdd_true;
-	}
-	if (cloned_right.nodes.size() == 1)
-	{
-		if (cloned_right.root->value.value == 1) return robdd_true;
-		else return cloned_left;
-	}
-	if (robdd1.root->label == robdd2.root->label)
-	{
-		ROBDD TrueROBDD, FalseROBDD;
-		ROBDD cloned_left_left, cloned_left_right, cloned_right_left, cloned_right_right;
-		NewNode = Clone(cloned_left.root->value.successor.true_branch);
-		cloned_left_left.root = NewNode;
-		cloned_left_left.nodes = NodeVector(cloned_left_left.root);
-		NewNode = Clone(cloned_left.root->value.successor.false_branch);
-		cloned_left_right.root = NewNode;
-		cloned_left_right.nodes = NodeVector(cloned_left_right.root);
-		NewNode = Clone(cloned_right.root->value.successor.true_branch);
-		cloned_right_left.root = NewNode;
-		cloned_right_left.nodes = NodeVector(cloned_right_left.root);
-		NewNode = Clone(cloned_right.root->value.successor.false_branch);
-		cloned_right_right.root = NewNode;
-		cloned_right_right.nodes = NodeVector(cloned_right_right.root);
-		TrueROBDD = IMPLY(cloned_left_left, cloned_right_left);
-		FalseROBDD = IMPLY(cloned_left_right, cloned_right_right);
-		ROBDD ret;
-		ret.root = new ROBDDNode;
-		ret.root->label = robdd1.root->label;
-		ret.root->value.successor.true_branch = TrueROBDD.root;
-		ret.root->value.successor.false_branch = FalseROBDD.root;
-		ret.nodes = NodeVector(ret.root);
-		for (int i = 0; i < ret.nodes.size(); i++)
-		{
-			if (ret.nodes[i]->label == 0)
-			{
-				ret.root = ret.nodes[i];
-				break;
-			}
-		}
-		ret.nodes = NodeVector(ret.root);
-		ret.Simplify();
-		return ret;
-	}
-	ROBDD ret;
-	if (!Contain(cloned_right.root, cloned_left.root->label))
-	{
-		ROBDD TrueROBDD, FalseROBDD;
-		ROBDD cloned_left_left, cloned_left_right;
-		NewNode = Clone(cloned_left.root->value.successor.true_branch);
-		cloned_left_left.root = NewNode;
-		cloned_left_left.nodes = NodeVector(cloned_left_left.root);
-		NewNode = Clone(cloned_left.root->value.successor.false_branch);
-		cloned_left_right.root = NewNode;
-		cloned_left_right.nodes = NodeVector(cloned_left_right.root);
-		TrueROBDD = IMPLY(cloned_left_left, cloned_right);
-		FalseROBDD = IMPLY(cloned_left_right, cloned_right);
-		ret.root = new ROBDDNode;
-		ret.root->label = robdd1.root->label;
-		ret.root->value.successor.true_branch = TrueROBDD.root;
-		ret.root->value.successor.false_branch = FalseROBDD.root;
-	}
-	else
-	{
-		ROBDD TrueROBDD, FalseROBDD;
-		ROBDD cloned_right_left, cloned_right_right;
-		NewNode = Clone(cloned_right.root->value.successor.true_branch);
-		cloned_right_left.root = NewNode;
-		cloned_right_left.nodes = NodeVector(cloned_right_left.root);
-		NewNode = Clone(cloned_right.root->value.successor.false_branch);
-		cloned_right_right.root = NewNode;
-		cloned_right_right.nodes = NodeVector(cloned_right_right.root);
-		TrueROBDD = IMPLY(cloned_right_left, cloned_left);
-		FalseROBDD = IMPLY(cloned_right_right, cloned_left);
-		ret.root = new ROBDDNode;
-		ret.root->label = robdd2.root->label;
-		ret.root->value.successor.true_branch = TrueROBDD.root;
-		ret.root->value.successor.false_branch = FalseROBDD.root;
-	}
-	ret.nodes = NodeVector(ret.root);
-	ret.Simplify();
-	return ret;
-}
-
-ROBDD NOT(ROBDD robdd)
-{
-	ROBDD ret = robdd.CloneROBDD();
-	ret.nodes = NodeVector(ret.root);
-	for (int i = 0; i < ret.nodes.size(); i++)
-	{
-		if (ret.nodes[i]->label == -1) ret.nodes[i]->value.value = 1 - ret.nodes[i]->value.value;
-	}
-	ret.Simplify();
-	return ret;
-}
-
-ROBDD EG(Graph G, ROBDD robdd)
-{ //V = {s ∈ T | ∃t ∈ U : s → t}
-	cout << "\nImplementing EG..." << endl;
-	int finished = 0;
-	ROBDD T = robdd.CloneROBDD();
-	ROBDD t0 = robdd.CloneROBDD();
-	ROBDD tn = t0.CloneROBDD();
-	int epoch = 0;
-	while (!finished)
-	{
-		cout << "\nEpoch " << epoch << endl;
-		ROBDD U = tn.CloneROBDD();
-		cout << "\nt" << epoch << ":" << endl;
-		tn.Print();
-		vector<int> P1_table;
-		int depth = ceil(log2(G.num_nodes));
-		for (int i = 0; i < G.num_nodes; i++)
-		{
-			for (int j = 0; j < G.nodes[i]->next.size(); j++)
-			{
-				P1_table.push_back((i << depth) + G.nodes[i]->nextidx[j]);
-			}
-		}
-		ROBDD P1, P2 = U.CloneROBDD();
-		P1.FromTrueValueVector(P1_table);
-		for (int i = 0; i < P2.nodes.size(); i++)
-		{
-			if (P2.nodes[i]->label >= 0) P2.nodes[i]->label += depth;
-		}
-		cout << "\nP1:" << endl;
-		P1.Print();
-		cout << "\nP2:" << endl;
-		P2.Print();
-		ROBDD P = AND(P1, P2);
-		cout << "\nP:" << endl;
-		P.Print();
-		vector<int> SPe_table;
-		for (int i = 0; i < pow(2,depth*2); i++)
-		{
-			if (P.Walk(i, depth * 2)) SPe_table.push_back(i >> depth);
-		}
-		ROBDD SPe;
-		SPe.FromTrueValueVector(SPe_table);
-		cout << "\nSPe:" << endl;
-		SPe.Print();
-		cout << "\nT:" << endl;
-		T.Print();
-		ROBDD V = AND(T, SPe);
-		cout << "\nV:" << endl;
-		V.Print();
-		ROBDD last = tn.CloneROBDD();
-		tn = AND(tn, V);
-		if (Equal(tn.root, last.root))
-		{
-			cout << "\ntn=tn-1" << endl;
-			finished = 1;
-		}
-		epoch++;
-	}
-	return tn;
-}
-
-ROBDD EX(Graph G, ROBDD robdd)
-{ //V = {s ∈ T | ∃t ∈ U : s → t}
-	cout << "\nImplementing EX..." << endl;
-	int finished = 0;
-	int depth = ceil(log2(G.num_nodes));
-	ROBDD U = robdd.CloneROBDD();
-	ROBDD T;
-	vector<int> T_tables;
-	for (int i = 0; i < G.num_nodes; i++)
-	{
-		T_tables.push_back(i);
-	}
-	T.FromTrueValueVector(T_tables);
-	ROBDD tn = U.CloneROBDD();
-	cout << "\nT:" << endl;
-	T.Print();
-	vector<int> P1_table;
-	for (int i = 0; i < G.num_nodes; i++)
-	{
-		for (int j = 0; j < G.nodes[i]->next.size(); j++)
-		{
-			P1_table.push_back((i << depth) + G.nodes[i]->nextidx[j]);
-		}
-	}
-	ROBDD P1, P2 = U.CloneROBDD();
-	P1.FromTrueValueVector(P1_table);
-	for (int i = 0; i < P2.nodes.size(); i++)
-	{
-		if (P2.nodes[i]->label >= 0) P2.nodes[i]->label += depth;
-	}
-	cout << "\nP1:" << endl;
-	P1.Print();
-	cout << "\nP2:" << endl;
-	P2.Print();
-	ROBDD P = AND(P1, P2);
-	cout << "\nP:" << endl;
-	P.Print();
-	vector<int> SPe_table;
-	for (int i = 0; i < pow(2, depth * 2); i++)
-	{
-		if (P.Walk(i, depth * 2)) SPe_table.push_back(i >> depth);
-	}
-	ROBDD SPe;
-	SPe.FromTrueValueVector(SPe_table);
-	cout << "\nSPe:" << endl;
-	SPe.Print();
-	ROBDD V = AND(T, SPe);
-	cout << "\nV:" << endl;
-	V.Print();
-	tn = AND(tn, V);
-	return tn;
-}
-
-ROBDD EU(Graph G, ROBDD robdd1, ROBDD robdd2)
-{ //V = {s ∈ T | ∃t ∈ U : s → t}
-	cout << "\nImplementing EU..." << endl;
-	int finished = 0;
-	ROBDD T = robdd1.CloneROBDD();
-	ROBDD u0 = robdd2.CloneROBDD();
-	ROBDD un = u0.CloneROBDD();
-	int epoch = 0;
-	while (!finished)
-	{
-		cout << "\nEpoch " << epoch << endl;
-		ROBDD U = un.CloneROBDD();
-		cout << "\nu" << epoch << ":" << endl;
-		un.Print();
-		vector<int> P1_table;
-		int depth = ceil(log2(G.num_nodes));
-		for (int i = 0; i < G.num_nodes; i++)
-		{
-			for (int j = 0; j < G.nodes[i]->next.size(); j++)
-			{
-				P1_table.push_back((i << depth) + G.nodes[i]->nextidx[j]);
-			}
-		}
-		ROBDD P1, P2 = U.CloneROBDD();
-		P1.FromTrueValueVector(P1_table);
-		for (int i = 0; i < P2.nodes.size(); i++)
-		{
-			if (P2.nodes[i]->label >= 0) P2.nodes[i]->label += depth;
-		}
-		cout << "\nP1:" << endl;
-		P1.Print();
-		cout << "\nP2:" << endl;
-		P2.Print();
-		ROBDD P = AND(P1, P2);
-		cout << "\nP:" << endl;
-		P.Print();
-		vector<int> SPe_table;
-		for (int i = 0; i < pow(2, depth * 2); i++)
-		{
-			if (P.Walk(i, depth * 2)) SPe_table.push_back(i >> depth);
-		}
-		ROBDD SPe;
-		SPe.FromTrueValueVector(SPe_table);
-		cout << "\nSPe:" << endl;
-		SPe.Print();
-		cout << "\nT:" << endl;
-		SPe.Print();
-		ROBDD V = AND(T, SPe);
-		cout << "\nV:" << endl;
-		V.Print();
-		ROBDD last = un.CloneROBDD();
-		un = OR(un, V);
-		if (Equal(un.root, last.root))
-		{
-			cout << "\nun=un-1" << endl;
-			finished = 1;
-		}
-		epoch++;
-	}
-	return un;
-}
-
-ROBDDNode * Clone(ROBDDNode* src)
-{
-	ROBDDNode* ret = new ROBDDNode;
-	if (src->label < 0)
-	{
-		ret->label = src->label;
-		ret->value.value = src->value.value;
-		return ret;
-	}
-	ret->label = src->label;
-	ret->value.successor.false_branch = Clone(src->value.successor.false_branch);
-	ret->value.successor.true_branch = Clone(src->value.successor.true_branch);
-	return ret;
-}
-
-bool Contain(ROBDDNode * node, int label)
-{
-	vector<ROBDDNode*> nodes;
-	nodes = NodeVector(node);
-	for (int i = 0; i < nodes.size(); i++)
-	{
-		if (nodes[i]->label == label) return true;
-	}
-	return false;
-}
+﻿#include "ROBDD.h"
+#include "Trace.h"
+#include "Parallel.h"
+#include "Explicit.h"
+#include "Stats.h"
+#include "MathFunc.h"
+#include <math.h>
+#include <unordered_map>
+#include <unordered_set>
+#include <algorithm>
+#include <iostream>
+using namespace std;
+
+static bool LevelLess(int label1, int label2)
+{
+	return Manager().Level(label1) < Manager().Level(label2);
+}
+
+static ROBDDRef Interval(unsigned long long first, unsigned long long last, int depth); //states first..last
+static ROBDDRef And(ROBDDRef f, ROBDDRef g, int depth = 0);
+static ROBDDRef Or(ROBDDRef f, ROBDDRef g, int depth = 0);
+
+static ROBDDRef FromSorted(const vector<unsigned long long>& keys, size_t first, size_t last, const vector<int>& vars, int position) //keys first..last-1 share their top position bits
+{
+	if (first == last) return ROBDD_FALSE;
+	int remaining = vars.size() - position;
+	if (remaining < 64 && last - first == (1ull << remaining)) return ROBDD_TRUE; //every state under this prefix, as keys are distinct
+	unsigned long long bit = 1ull << (remaining - 1);
+	size_t middle = partition_point(keys.begin() + first, keys.begin() + last, [bit](unsigned long long key) { return (key & bit) == 0; }) - keys.begin();
+	ROBDDRef TrueNode = FromSorted(keys, middle, last, vars, position + 1);
+	ROBDDRef FalseNode = FromSorted(keys, first, middle, vars, position + 1);
+	return Manager().MakeNode(vars[position], TrueNode, FalseNode);
+}
+
+static ROBDDRef FromPaths(vector<unsigned long long> keys, int depth) //bottom-up through the unique table, O(k*n) for k paths of n bits
+{
+	STAT_SCOPE(STAT_BUILD);
+	if (keys.empty()) return ROBDD_FALSE;
+	Manager().MaybeCollect();
+	sort(keys.begin(), keys.end());
+	keys.erase(unique(keys.begin(), keys.end()), keys.end());
+	if (keys.size() > 1 && keys.back() - keys.front() == keys.size() - 1) return Interval(keys.front(), keys.back(), depth); //one contiguous block
+	int high = max(0, depth - 64); //x_0..x_(high-1) lie past the 64 bits of a key, so they are 0 on every path
+	vector<int> vars; //bit i of a path is x_i, counted from the most significant bit
+	for (int i = high; i < depth; i++) vars.push_back(i);
+	sort(vars.begin(), vars.end(), LevelLess);
+	bool identity = true;
+	for (int i = 0; i < vars.size(); i++) identity = identity && vars[i] == high + i;
+	if (!identity) //reorder the bits of each key to the variable order, so that sorting groups shared prefixes
+	{
+		for (int i = 0; i < keys.size(); i++)
+		{
+			unsigned long long key = 0;
+			for (int j = 0; j < vars.size(); j++) key = key << 1 | (keys[i] >> (depth - 1 - vars[j]) & 1);
+			keys[i] = key;
+		}
+		sort(keys.begin(), keys.end());
+	}
+	ROBDDRef ret = FromSorted(keys, 0, keys.size(), vars, 0);
+	if (high > 0) ret = And(Interval(0, 0, high), ret);
+	return ret;
+}
+
+static ROBDDRef FromPaths(const vector<int>& paths, int depth)
+{
+	return FromPaths(vector<unsigned long long>(paths.begin(), paths.end()), depth);
+}
+
+static ROBDDRef FromCube(const vector<signed char>& cube) //x_l fixed where cube[l] is 1 or 0
+{
+	vector<int> vars;
+	for (int i = 0; i < cube.size(); i++)
+	{
+		if (cube[i] != -1) vars.push_back(i);
+	}
+	sort(vars.begin(), vars.end(), LevelLess);
+	ROBDDRef ret = ROBDD_TRUE;
+	for (int i = (int)vars.size() - 1; i >= 0; i--)
+	{
+		if (cube[vars[i]] == 1) ret = Manager().MakeNode(vars[i], ret, ROBDD_FALSE);
+		else ret = Manager().MakeNode(vars[i], ROBDD_FALSE, ret);
+	}
+	return ret;
+}
+
+ROBDD::ROBDD()
+{
+	root = ROBDD_FALSE;
+	Manager().Register(this);
+}
+
+ROBDD::ROBDD(const ROBDD& other)
+{
+	root = other.root;
+	Manager().Register(this);
+}
+
+ROBDD& ROBDD::operator=(const ROBDD& other)
+{
+	root = other.root;
+	return *this;
+}
+
+ROBDD::~ROBDD()
+{
+	Manager().Unregister(this);
+}
+
+void ROBDD::ConvertFromGraph(const Graph& graph)
+{
+	vector<int> TrueValues;
+	for (int i = 0; i < graph.num_nodes; i++)
+	{
+		if (graph.Value(i) != 0) TrueValues.push_back(i);
+	}
+	root = FromPaths(TrueValues, graph.Depth());
+}
+
+void ROBDD::FromTrueValueVector(const vector<int>& TrueValues)
+{
+	int max = 0;
+	for (int i = 0; i < TrueValues.size(); i++)
+	{
+		if (TrueValues[i] > max) max = TrueValues[i];
+	}
+	root = FromPaths(TrueValues, BitsFor(max + 1ull));
+}
+
+void ROBDD::FromTrueValueVector(const vector<int>& TrueValues, int depth)
+{
+	root = FromPaths(TrueValues, depth);
+}
+
+void ROBDD::FromTrueValueVector(const vector<unsigned long long>& TrueValues, int depth)
+{
+	root = FromPaths(TrueValues, depth);
+}
+
+void ROBDD::FromCubes(const vector<vector<signed char> >& cubes)
+{
+	STAT_SCOPE(STAT_BUILD);
+	Manager().MaybeCollect();
+	root = ROBDD_FALSE;
+	for (int i = 0; i < cubes.size(); i++) root = Or(root, FromCube(cubes[i]));
+}
+
+void ROBDD::FromRange(unsigned long long first, unsigned long long last, int depth)
+{
+	STAT_SCOPE(STAT_BUILD);
+	Manager().MaybeCollect();
+	root = Interval(first, last, depth);
+}
+
+void ROBDD::FromConstant(int value)
+{
+	root = Manager().Leaf(value);
+}
+
+void ROBDD::Simplify()
+{
+	STAT_SCOPE(STAT_SIMPLIFY);
+}
+
+static ROBDDRef Child(ROBDDRef node, bool branch) //branch of the function node stands for, complement bit pushed down
+{
+	ROBDDNode& n = Manager().Node(node);
+	return (branch ? n.true_branch : n.false_branch) ^ (node & 1);
+}
+
+void ROBDD::Print()
+{
+	Print(cout);
+	cout << flush;
+}
+
+void ROBDD::Print(ostream& out)
+{
+	vector<ROBDDRef> nodes = NodeVector(root);
+	unordered_map<ROBDDRef, int> ID;
+	for (int i = 0; i < nodes.size(); i++) ID[nodes[i]] = i;
+	for (int i = 0; i < nodes.size(); i++)
+	{
+		int label = Manager().Node(nodes[i]).label;
+		if (label != -1)
+		{
+			ROBDDRef TrueNode = Child(nodes[i], true);
+			ROBDDRef FalseNode = Child(nodes[i], false);
+			if (Manager().Node(FalseNode).label != -1)
+				out << ID[nodes[i]] << "(tests x" << label << ")" << "  ----False---->  " << ID[FalseNode] << '\n';
+			else
+				if (FalseNode == ROBDD_TRUE)
+					out << ID[nodes[i]] << "(tests x" << label << ")" << "  ----False---->  " << ID[FalseNode] << "(True)" << '\n';
+				else
+					out << ID[nodes[i]] << "(tests x" << label << ")" << "  ----False---->  " << ID[FalseNode] << "(False)" << '\n';
+			if (Manager().Node(TrueNode).label != -1)
+				out << ID[nodes[i]] << "(tests x" << label << ")" << "  ----True---->  " << ID[TrueNode] << '\n';
+			else
+				if (TrueNode == ROBDD_TRUE)
+					out << ID[nodes[i]] << "(tests x" << label << ")" << "  ----True---->  " << ID[TrueNode] << "(True)" << '\n';
+				else
+					out << ID[nodes[i]] << "(tests x" << label << ")" << "  ----True---->  " << ID[TrueNode] << "(False)" << '\n';
+		}
+		else
+		{
+			if (nodes[i] == ROBDD_TRUE)
+				out << ID[nodes[i]] << "  stands for True" << '\n';
+			else
+				out << ID[nodes[i]] << "  stands for False" << '\n';
+		}
+	}
+}
+
+static void CountNodes(ROBDDRef node, unordered_set<ROBDDRef>& visited, vector<bool>& support)
+{
+	if (Manager().Node(node).label == -1 || !visited.insert(Regular(node)).second) return;
+	int label = Manager().Node(node).label;
+	if (label >= support.size()) support.resize(label + 1, false);
+	support[label] = true;
+	CountNodes(Manager().Node(node).true_branch, visited, support);
+	CountNodes(Manager().Node(node).false_branch, visited, support);
+}
+
+int ROBDD::NodeCount()
+{
+	unordered_set<ROBDDRef> visited;
+	vector<bool> support;
+	CountNodes(root, visited, support);
+	return visited.size() + 1;
+}
+
+vector<int> ROBDD::Support()
+{
+	unordered_set<ROBDDRef> visited;
+	vector<bool> support;
+	CountNodes(root, visited, support);
+	vector<int> ret;
+	for (int i = 0; i < support.size(); i++)
+	{
+		if (support[i]) ret.push_back(i);
+	}
+	return ret;
+}
+
+static double Density(ROBDDRef node, unordered_map<ROBDDRef, double>& memo) //fraction of all assignments that satisfy node
+{
+	if (IsComplement(node)) return 1 - Density(Complement(node), memo);
+	if (node == ROBDD_TRUE) return 1;
+	unordered_map<ROBDDRef, double>::iterator it = memo.find(node);
+	if (it != memo.end()) return it->second;
+	double ret = (Density(Manager().Node(node).true_branch, memo) + Density(Manager().Node(node).false_branch, memo)) / 2;
+	memo[node] = ret;
+	return ret;
+}
+
+double ROBDD::SatCount(int nvars)
+{
+	unordered_map<ROBDDRef, double> memo;
+	return ldexp(Density(root, memo), nvars);
+}
+
+struct BigCount //unsigned integer of any size, 32 bits to a word, least significant first
+{
+	vector<unsigned> words;
+	void Add(const BigCount& other)
+	{
+		if (words.size() < other.words.size()) words.resize(other.words.size(), 0);
+		unsigned long long carry = 0;
+		for (int i = 0; i < words.size(); i++)
+		{
+			carry += (unsigned long long)words[i] + (i < other.words.size() ? other.words[i] : 0);
+			words[i] = (unsigned)carry;
+			carry >>= 32;
+		}
+		if (carry != 0) words.push_back((unsigned)carry);
+	}
+	void Subtract(const BigCount& other) //other must not be larger
+	{
+		long long borrow = 0;
+		for (int i = 0; i < words.size(); i++)
+		{
+			long long difference = (long long)words[i] - (i < other.words.size() ? other.words[i] : 0) - borrow;
+			borrow = difference < 0 ? 1 : 0;
+			words[i] = (unsigned)(difference + (borrow << 32));
+		}
+	}
+	void ShiftRight(int bits)
+	{
+		for (; bits > 0; bits--)
+		{
+			for (int i = 0; i < words.size(); i++) words[i] = (words[i] >> 1) | (i + 1 < words.size() ? words[i + 1] << 31 : 0);
+		}
+	}
+	static BigCount Power(int exponent) //2^exponent
+	{
+		BigCount ret;
+		ret.words.assign(exponent / 32 + 1, 0);
+		ret.words.back() = 1u << (exponent % 32);
+		return ret;
+	}
+	string Decimal() const
+	{
+		vector<unsigned> digits = words; //divided by 10^9 until nothing is left
+		string ret;
+		do
+		{
+			unsigned long long remainder = 0;
+			for (int i = (int)digits.size() - 1; i >= 0; i--)
+			{
+				unsigned long long current = (remainder << 32) | digits[i];
+				digits[i] = (unsigned)(current / 1000000000);
+				remainder = current % 1000000000;
+			}
+			while (!digits.empty() && digits.back() == 0) digits.pop_back();
+			string chunk = to_string(remainder);
+			if (!digits.empty()) chunk = string(9 - chunk.size(), '0') + chunk;
+			ret = chunk + ret;
+		} while (!digits.empty());
+		return ret;
+	}
+};
+
+static BigCount Count(ROBDDRef node, int nvars, unordered_map<ROBDDRef, BigCount>& memo) //assignments of x_0..x_(nvars-1) satisfying node, every label is below nvars
+{
+	if (IsComplement(node))
+	{
+		BigCount ret = BigCount::Power(nvars);
+		ret.Subtract(Count(Complement(node), nvars, memo));
+		return ret;
+	}
+	if (node == ROBDD_TRUE) return BigCount::Power(nvars);
+	unordered_map<ROBDDRef, BigCount>::iterator it = memo.find(node);
+	if (it != memo.end()) return it->second;
+	BigCount ret = Count(Manager().Node(node).true_branch, nvars, memo);
+	ret.Add(Count(Manager().Node(node).false_branch, nvars, memo));
+	ret.ShiftRight(1); //each branch counted its own variable both ways
+	memo[node] = ret;
+	return ret;
+}
+
+string ROBDD::ExactSatCount(int nvars)
+{
+	vector<int> support = Support();
+	int counted = support.empty() ? nvars : max(nvars, support.back() + 1);
+	unordered_map<ROBDDRef, BigCount> memo;
+	BigCount ret = Count(root, counted, memo);
+	ret.ShiftRight(counted - nvars); //averages over the variables past nvars
+	return ret.Decimal();
+}
+
+ROBDD ROBDD::PickOne(int nvars)
+{
+	ROBDD ret;
+	if (root == ROBDD_FALSE) return ret;
+	vector<signed char> value(nvars, 0);
+	for (ROBDDRef node = root; Manager().Node(node).label != -1;)
+	{
+		int label = Manager().Node(node).label;
+		bool branch = Child(node, true) != ROBDD_FALSE;
+		if (label < nvars) value[label] = branch;
+		node = Child(node, branch);
+	}
+	ret.root = FromCube(value);
+	return ret;
+}
+
+CubeIterator::CubeIterator(ROBDD robdd, int nvars) : robdd(robdd), cube(nvars, -1)
+{
+	started = false;
+}
+
+bool CubeIterator::Next()
+{
+	ROBDDRef node = ROBDD_NULL; //where the next descent starts
+	if (!started)
+	{
+		started = true;
+		node = robdd.root;
+	}
+	while (1)
+	{
+		if (node != ROBDD_NULL)
+		{
+			int label;
+			while ((label = Manager().Node(node).label) != -1) //true branches first
+			{
+				frames.push_back(make_pair(node, false));
+				if (label < cube.size()) cube[label] = 1;
+				node = Child(node, true);
+			}
+			if (node == ROBDD_TRUE) return true;
+		}
+		while (!frames.empty() && frames.back().second) //back to the last node whose false branch is left
+		{
+			int label = Manager().Node(frames.back().first).label;
+			if (label < cube.size()) cube[label] = -1;
+			frames.pop_back();
+		}
+		if (frames.empty()) return false;
+		frames.back().second = true;
+		int label = Manager().Node(frames.back().first).label;
+		if (label < cube.size()) cube[label] = 0;
+		node = Child(frames.back().first, false);
+	}
+}
+
+StateIterator::StateIterator(ROBDD robdd, int depth) : cubes(robdd, depth)
+{
+	this->depth = depth;
+	in_cube = false;
+}
+
+bool StateIterator::Next(unsigned long long& state)
+{
+	while (!in_cube)
+	{
+		if (!cubes.Next()) return false;
+		value = free = sub = 0;
+		for (int i = 0; i < depth; i++)
+		{
+			unsigned long long bit = 1ull << (depth - 1 - i);
+			if (cubes.Cube()[i] == 1) value |= bit;
+			else if (cubes.Cube()[i] == -1) free |= bit;
+		}
+		in_cube = true;
+	}
+	state = value | sub;
+	sub = (sub - free) & free; //next subset of the free bits
+	if (sub == 0) in_cube = false;
+	return true;
+}
+
+ROBDD ROBDD::CloneROBDD() //nodes are immutable, so sharing the root is a full copy
+{
+	ROBDD ret;
+	ret.root = root;
+	return ret;
+}
+
+bool ROBDD::Walk(unsigned long long path, int pathlen)
+{
+	ROBDDRef current = root;
+	int label;
+	while ((label = Manager().Node(current).label) != -1 && label < pathlen) current = Child(current, pathlen - 1 - label < 64 && (path >> (pathlen - 1 - label) & 1)); //x_0 is the most significant bit
+	if (current == ROBDD_FALSE) return false;
+	return true;
+}
+
+bool ROBDD::Walk(const vector<unsigned long long>& path, int pathlen)
+{
+	ROBDDRef current = root;
+	int label;
+	while ((label = Manager().Node(current).label) != -1 && label < pathlen)
+	{
+		int bit = pathlen - 1 - label; //counted from the least significant bit of the last word
+		current = Child(current, bit / 64 < path.size() && (path[path.size() - 1 - bit / 64] >> (bit % 64) & 1));
+	}
+	if (current == ROBDD_FALSE) return false;
+	return true;
+}
+
+void ROBDD::Walk(const uint64_t* paths, size_t count, int pathlen, uint64_t* result)
+{
+	BatchEvaluator evaluator(*this);
+	evaluator.Evaluate(paths, count, pathlen, result);
+}
+
+static int Collect(ROBDDRef node, unordered_map<ROBDDRef, int>& index, vector<ROBDDRef>& found, vector<pair<int, int> >& children) //position of the regular node in found, adding it and the nodes below it on the first visit
+{
+	node = Regular(node);
+	pair<unordered_map<ROBDDRef, int>::iterator, bool> inserted = index.insert(make_pair(node, (int)found.size()));
+	if (!inserted.second) return inserted.first->second;
+	int position = found.size();
+	found.push_back(node);
+	children.push_back(make_pair(-1, -1));
+	if (node == ROBDD_TRUE) return position;
+	int false_child = Collect(Manager().Node(node).false_branch, index, found, children);
+	int true_child = Collect(Manager().Node(node).true_branch, index, found, children);
+	children[position] = make_pair(false_child, true_child);
+	return position;
+}
+
+BatchEvaluator::BatchEvaluator(ROBDD robdd) : robdd(robdd)
+{
+	unordered_map<ROBDDRef, int> index;
+	vector<ROBDDRef> found;
+	vector<pair<int, int> > children;
+	int top = Collect(robdd.root, index, found, children);
+	int num_vars = Manager().NumVars();
+	vector<int> level(found.size()), start(num_vars + 2, 0), position(found.size());
+	for (int i = 0; i < found.size(); i++) //counting sort by level, the leaf below every variable
+	{
+		int label = Manager().Node(found[i]).label;
+		level[i] = label == -1 ? num_vars : Manager().Level(label);
+		start[level[i] + 1]++;
+	}
+	for (int l = 0; l <= num_vars; l++) start[l + 1] += start[l];
+	for (int i = 0; i < found.size(); i++) position[i] = start[level[i]]++;
+	nodes.resize(found.size());
+	for (int i = 0; i < found.size(); i++)
+	{
+		ROBDDNode& node = Manager().Node(found[i]);
+		FlatNode& flat = nodes[position[i]];
+		flat.label = node.label;
+		flat.level = level[i];
+		if (node.label == -1) continue;
+		flat.children[0] = position[children[i].first] << 1 | (IsComplement(node.false_branch) ? 1 : 0);
+		flat.children[1] = position[children[i].second] << 1;
+	}
+	root = position[top] << 1 | (IsComplement(robdd.root) ? 1 : 0);
+	masks.assign(2 * nodes.size(), 0);
+	active.resize(num_vars + 1);
+}
+
+uint64_t BatchEvaluator::Evaluate(const uint64_t* slices, int nvars)
+{
+	uint64_t ret = 0;
+	masks[2 * (root >> 1) + (root & 1)] = ~0ull;
+	active[nodes[root >> 1].level].push_back(root >> 1);
+	for (int level = nodes[root >> 1].level; level < active.size(); level++) //every edge points to a lower level
+	{
+		for (int i = 0; i < active[level].size(); i++)
+		{
+			int index = active[level][i];
+			const FlatNode& node = nodes[index];
+			uint64_t reached[2] = { masks[2 * index], masks[2 * index + 1] }; //even and odd parity
+			masks[2 * index] = masks[2 * index + 1] = 0;
+			if (node.label == -1) //complemented an odd number of times, the leaf means False
+			{
+				ret |= reached[0];
+				continue;
+			}
+			if (node.label >= nvars) //some assignment of the rest satisfies a node that is not a leaf
+			{
+				ret |= reached[0] | reached[1];
+				continue;
+			}
+			uint64_t single = reached[0] | reached[1];
+			if ((single & (single - 1)) == 0) //one assignment left on this path, cheaper to walk it alone
+			{
+				int bit = 0;
+				while ((single >> bit & 1) == 0) bit++;
+				int edge = index << 1 | (reached[1] != 0 ? 1 : 0);
+				while (nodes[edge >> 1].label != -1 && nodes[edge >> 1].label < nvars)
+				{
+					int child = nodes[edge >> 1].children[slices[nodes[edge >> 1].label] >> bit & 1];
+					edge = (child & ~1) | ((edge ^ child) & 1);
+				}
+				if (nodes[edge >> 1].label != -1 || (edge & 1) == 0) ret |= single;
+				continue;
+			}
+			uint64_t value = slices[node.label];
+			for (int branch = 0; branch < 2; branch++)
+			{
+				int child = node.children[branch] >> 1;
+				bool was_reached = (masks[2 * child] | masks[2 * child + 1]) != 0;
+				for (int parity = 0; parity < 2; parity++)
+				{
+					uint64_t going = reached[parity] & (branch ? value : ~value);
+					masks[2 * child + (parity ^ (node.children[branch] & 1))] |= going;
+				}
+				if (!was_reached && (masks[2 * child] | masks[2 * child + 1]) != 0) active[nodes[child].level].push_back(child);
+			}
+		}
+		active[level].clear();
+	}
+	return ret;
+}
+
+static void Transpose(uint64_t rows[64]) //bit j of row i becomes bit i of row j
+{
+	uint64_t mask = 0x00000000FFFFFFFFull;
+	for (int width = 32; width != 0; width >>= 1, mask ^= mask << width) //swaps the off-diagonal blocks of width x width
+	{
+		for (int i = 0; i < 64; i = (i + width + 1) & ~width)
+		{
+			uint64_t swapped = ((rows[i] >> width) ^ rows[i + width]) & mask;
+			rows[i] ^= swapped << width;
+			rows[i + width] ^= swapped;
+		}
+	}
+}
+
+void BatchEvaluator::Evaluate(const uint64_t* states, size_t count, int depth, uint64_t* result)
+{
+	uint64_t bits[64], slices[64];
+	for (size_t first = 0; first < count; first += 64)
+	{
+		size_t block = min<size_t>(64, count - first);
+		copy(states + first, states + first + block, bits);
+		fill(bits + block, bits + 64, 0);
+		Transpose(bits); //bits[b] now holds bit b of every state
+		for (int l = 0; l < depth; l++) slices[l] = bits[depth - 1 - l];
+		result[first / 64] = Evaluate(slices, depth) & (block == 64 ? ~0ull : (1ull << block) - 1);
+	}
+}
+
+static void NodeVector(ROBDDRef node, vector<ROBDDRef>& ret, unordered_set<ROBDDRef>& visited)
+{
+	if (!visited.insert(node).second) return;
+	ret.push_back(node);
+	if (Manager().Node(node).label >= 0)
+	{
+		NodeVector(Child(node, true), ret, visited);
+		NodeVector(Child(node, false), ret, visited);
+	}
+}
+
+vector<ROBDDRef> NodeVector(ROBDDRef StartVector)
+{
+	vector<ROBDDRef> ret;
+	unordered_set<ROBDDRef> visited;
+	NodeVector(StartVector, ret, visited);
+	return ret;
+}
+
+bool Equal(ROBDDRef node1, ROBDDRef node2) //nodes are unique per function
+{
+	return node1 == node2;
+}
+
+static int MinLabel(int label1, int label2) //the label tested first in the variable order, leaves (-1) come last
+{
+	return Manager().Level(label1) < Manager().Level(label2) ? label1 : label2;
+}
+
+static int TopLabel(ROBDDRef node1, ROBDDRef node2) //smallest label tested by either root
+{
+	return MinLabel(Manager().Node(node1).label, Manager().Node(node2).label);
+}
+
+static ROBDDRef Branch(ROBDDRef node, int label, bool branch) //cofactor of node for the given value of label
+{
+	if (Manager().Node(node).label != label) return node;
+	return Child(node, branch);
+}
+
+static ROBDDRef Var(int label)
+{
+	return Manager().MakeNode(label, ROBDD_TRUE, ROBDD_FALSE);
+}
+
+struct ApplyTask : Task //one cofactor of an apply, spawned so that another worker may compute it
+{
+	int op;
+	ROBDDRef f, g, h;
+	int depth;
+	ROBDDRef result;
+};
+
+static ROBDDRef ITE(ROBDDRef f, ROBDDRef g, ROBDDRef h, int depth = 0);
+static ROBDDRef Exists(ROBDDRef f, ROBDDRef cube, int depth = 0);
+static ROBDDRef AndExists(ROBDDRef f, ROBDDRef g, ROBDDRef cube, int depth = 0);
+
+static ROBDDRef Apply(int op, ROBDDRef f, ROBDDRef g, ROBDDRef h, int depth)
+{
+	switch (op)
+	{
+	case OP_AND:
+		return And(f, g, depth);
+	case OP_ITE:
+		return ITE(f, g, h, depth);
+	case OP_EXISTS:
+		return Exists(f, g, depth);
+	default:
+		return AndExists(f, g, h, depth);
+	}
+}
+
+static void RunApply(Task* task)
+{
+	ApplyTask* apply = (ApplyTask*)task;
+	apply->result = Apply(apply->op, apply->f, apply->g, apply->h, apply->depth);
+}
+
+static void Cofactors(int op, ROBDDRef f1, ROBDDRef g1, ROBDDRef h1, ROBDDRef f0, ROBDDRef g0, ROBDDRef h0, int depth, ROBDDRef& TrueNode, ROBDDRef& FalseNode) //the two recursions of an apply, in parallel above the spawn cutoff
+{
+	if (!CanSpawn(depth))
+	{
+		TrueNode = Apply(op, f1, g1, h1, depth + 1);
+		FalseNode = Apply(op, f0, g0, h0, depth + 1);
+		return;
+	}
+	ApplyTask task;
+	task.run = RunApply;
+	task.op = op;
+	task.f = f1;
+	task.g = g1;
+	task.h = h1;
+	task.depth = depth + 1;
+	Spawn(task);
+	FalseNode = Apply(op, f0, g0, h0, depth + 1);
+	Sync(task);
+	TrueNode = task.result;
+}
+
+static ROBDDRef And(ROBDDRef f, ROBDDRef g, int depth) //Shannon expansion on the top label, memoized in the computed table
+{
+	if (f == ROBDD_FALSE || g == ROBDD_FALSE || f == Complement(g)) return ROBDD_FALSE;
+	if (f == ROBDD_TRUE || f == g) return g;
+	if (g == ROBDD_TRUE) return f;
+	if (g < f) swap(f, g); //AND commutes, so both orders share a cache entry
+	STAT_STEP(OP_AND, depth);
+	ROBDDRef ret;
+	if (Manager().CacheLookup(OP_AND, f, g, ret)) return ret;
+	int label = TopLabel(f, g);
+	ROBDDRef TrueNode, FalseNode;
+	Cofactors(OP_AND, Branch(f, label, true), Branch(g, label, true), ROBDD_TRUE, Branch(f, label, false), Branch(g, label, false), ROBDD_TRUE, depth, TrueNode, FalseNode);
+	ret = Manager().MakeNode(label, TrueNode, FalseNode);
+	Manager().CacheInsert(OP_AND, f, g, ret);
+	return ret;
+}
+
+static ROBDDRef Or(ROBDDRef f, ROBDDRef g, int depth)
+{
+	return Complement(And(Complement(f), Complement(g), depth));
+}
+
+static ROBDDRef ITE(ROBDDRef f, ROBDDRef g, ROBDDRef h, int depth) //if f then g else h
+{
+	if (f == ROBDD_TRUE || g == h) return g;
+	if (f == ROBDD_FALSE) return h;
+	if (IsComplement(f))
+	{
+		f = Complement(f);
+		swap(g, h);
+	}
+	if (g == ROBDD_TRUE || g == f) return Or(f, h, depth);
+	if (g == ROBDD_FALSE || g == Complement(f)) return And(Complement(f), h, depth);
+	if (h == ROBDD_FALSE || h == f) return And(f, g, depth);
+	if (h == ROBDD_TRUE || h == Complement(f)) return Or(Complement(f), g, depth);
+	if (IsComplement(g)) return Complement(ITE(f, Complement(g), Complement(h), depth)); //keep g regular so complements share entries
+	STAT_STEP(OP_ITE, depth);
+	ROBDDRef ret;
+	if (Manager().CacheLookup(OP_ITE, f, g, h, ret)) return ret;
+	int label = MinLabel(TopLabel(f, g), Manager().Node(h).label);
+	ROBDDRef TrueNode, FalseNode;
+	Cofactors(OP_ITE, Branch(f, label, true), Branch(g, label, true), Branch(h, label, true), Branch(f, label, false), Branch(g, label, false), Branch(h, label, false), depth, TrueNode, FalseNode);
+	ret = Manager().MakeNode(label, TrueNode, FalseNode);
+	Manager().CacheInsert(OP_ITE, f, g, h, ret);
+	return ret;
+}
+
+static ROBDDRef Cube(vector<int> vars) //conjunction of the given variables, in any order
+{
+	sort(vars.begin(), vars.end(), LevelLess);
+	vars.erase(unique(vars.begin(), vars.end()), vars.end());
+	ROBDDRef ret = ROBDD_TRUE;
+	for (int i = (int)vars.size() - 1; i >= 0; i--) ret = Manager().MakeNode(vars[i], ret, ROBDD_FALSE);
+	return ret;
+}
+
+static ROBDDRef Cube(int first, int count) //conjunction of x_first..x_(first+count-1)
+{
+	vector<int> vars;
+	for (int i = 0; i < count; i++) vars.push_back(first + i);
+	return Cube(vars);
+}
+
+static ROBDDRef Interval(unsigned long long first, unsigned long long last, int depth) //O(n) nodes, whatever the variable order
+{
+	if (depth < 64) last = min(last, (1ull << depth) - 1);
+	if (first > last) return ROBDD_FALSE;
+	ROBDDRef above = ROBDD_TRUE, below = ROBDD_TRUE; //x >= first and x <= last on the bits from i down
+	for (int i = depth - 1; i >= 0; i--)
+	{
+		ROBDDRef var = Var(i);
+		if (depth - 1 - i >= 64) //past the bits of first and last, both 0
+		{
+			above = Or(var, above);
+			below = And(Complement(var), below);
+			continue;
+		}
+		if (first >> (depth - 1 - i) & 1) above = And(var, above);
+		else above = Or(var, above);
+		if (last >> (depth - 1 - i) & 1) below = Or(Complement(var), below);
+		else below = And(Complement(var), below);
+	}
+	return And(above, below);
+}
+
+static ROBDDRef SkipCube(ROBDDRef cube, int label) //drops the cube variables tested above label
+{
+	while (cube != ROBDD_TRUE && LevelLess(Manager().Node(cube).label, label)) cube = Manager().Node(cube).true_branch;
+	return cube;
+}
+
+static ROBDDRef Exists(ROBDDRef f, ROBDDRef cube, int depth)
+{
+	int label = Manager().Node(f).label;
+	cube = SkipCube(cube, label);
+	if (label == -1 || cube == ROBDD_TRUE) return f;
+	STAT_STEP(OP_EXISTS, depth);
+	ROBDDRef ret;
+	if (Manager().CacheLookup(OP_EXISTS, f, cube, ret)) return ret;
+	ROBDDRef TrueNode, FalseNode;
+	if (Manager().Node(cube).label == label)
+	{
+		ROBDDRef rest = Manager().Node(cube).true_branch;
+		if (CanSpawn(depth)) Cofactors(OP_EXISTS, Child(f, true), rest, ROBDD_TRUE, Child(f, false), rest, ROBDD_TRUE, depth, TrueNode, FalseNode);
+		else
+		{
+			TrueNode = Exists(Child(f, true), rest, depth + 1);
+			FalseNode = TrueNode == ROBDD_TRUE ? ROBDD_TRUE : Exists(Child(f, false), rest, depth + 1); //nothing to add to True
+		}
+		ret = Or(TrueNode, FalseNode, depth + 1);
+	}
+	else
+	{
+		Cofactors(OP_EXISTS, Child(f, true), cube, ROBDD_TRUE, Child(f, false), cube, ROBDD_TRUE, depth, TrueNode, FalseNode);
+		ret = Manager().MakeNode(label, TrueNode, FalseNode);
+	}
+	Manager().CacheInsert(OP_EXISTS, f, cube, ret);
+	return ret;
+}
+
+static ROBDDRef AndExists(ROBDDRef f, ROBDDRef g, ROBDDRef cube, int depth) //relational product, EXISTS cube. f AND g without building f AND g
+{
+	if (f == ROBDD_FALSE || g == ROBDD_FALSE || f == Complement(g)) return ROBDD_FALSE;
+	if (f == ROBDD_TRUE || f == g) return Exists(g, cube, depth);
+	if (g == ROBDD_TRUE) return Exists(f, cube, depth);
+	int label = TopLabel(f, g);
+	cube = SkipCube(cube, label);
+	if (cube == ROBDD_TRUE) return And(f, g, depth);
+	if (g < f) swap(f, g);
+	STAT_STEP(OP_AND_EXISTS, depth);
+	ROBDDRef ret;
+	if (Manager().CacheLookup(OP_AND_EXISTS, f, g, cube, ret)) return ret;
+	ROBDDRef TrueNode, FalseNode;
+	if (Manager().Node(cube).label == label)
+	{
+		ROBDDRef rest = Manager().Node(cube).true_branch;
+		if (CanSpawn(depth)) Cofactors(OP_AND_EXISTS, Branch(f, label, true), Branch(g, label, true), rest, Branch(f, label, false), Branch(g, label, false), rest, depth, TrueNode, FalseNode);
+		else
+		{
+			TrueNode = AndExists(Branch(f, label, true), Branch(g, label, true), rest, depth + 1);
+			FalseNode = TrueNode == ROBDD_TRUE ? ROBDD_TRUE : AndExists(Branch(f, label, false), Branch(g, label, false), rest, depth + 1);
+		}
+		ret = Or(TrueNode, FalseNode, depth + 1);
+	}
+	else
+	{
+		Cofactors(OP_AND_EXISTS, Branch(f, label, true), Branch(g, label, true), cube, Branch(f, label, false), Branch(g, label, false), cube, depth, TrueNode, FalseNode);
+		ret = Manager().MakeNode(label, TrueNode, FalseNode);
+	}
+	Manager().CacheInsert(OP_AND_EXISTS, f, g, cube, ret);
+	return ret;
+}
+
+static ROBDDRef Restrict(ROBDDRef f, ROBDDRef literal) //cofactor of f where the literal's variable takes the literal's value
+{
+	int label = Manager().Node(f).label;
+	int var = Manager().Node(literal).label;
+	if (label == -1 || LevelLess(var, label)) return f;
+	if (label == var) return Child(f, !IsComplement(literal));
+	ROBDDRef ret;
+	if (Manager().CacheLookup(OP_RESTRICT, f, literal, ret)) return ret;
+	ROBDDRef TrueNode = Restrict(Child(f, true), literal);
+	ROBDDRef FalseNode = Restrict(Child(f, false), literal);
+	ret = Manager().MakeNode(label, TrueNode, FalseNode);
+	Manager().CacheInsert(OP_RESTRICT, f, literal, ret);
+	return ret;
+}
+
+static ROBDDRef Rename(ROBDDRef f, const vector<int>& permutation, unordered_map<ROBDDRef, ROBDDRef>& renamed) //x_i becomes x_permutation[i]
+{
+	if (IsComplement(f)) return Complement(Rename(Complement(f), permutation, renamed));
+	int label = Manager().Node(f).label;
+	if (label == -1) return f;
+	unordered_map<ROBDDRef, ROBDDRef>::iterator it = renamed.find(f);
+	if (it != renamed.end()) return it->second;
+	ROBDDRef TrueNode = Rename(Child(f, true), permutation, renamed);
+	ROBDDRef FalseNode = Rename(Child(f, false), permutation, renamed);
+	int target = label < permutation.size() ? permutation[label] : label;
+	int below = TopLabel(TrueNode, FalseNode);
+	ROBDDRef ret;
+	if (LevelLess(target, below))
+		ret = Manager().MakeNode(target, TrueNode, FalseNode); //still ordered, no need to rebuild
+	else
+		ret = ITE(Var(target), TrueNode, FalseNode);
+	renamed[f] = ret;
+	return ret;
+}
+
+struct ParallelSection //lets the other workers join the operations run in its scope
+{
+	bool parallel;
+	ParallelSection()
+	{
+		parallel = Workers() > 1;
+		if (!parallel) return;
+		Manager().BeginConcurrent();
+		BeginParallel();
+	}
+	~ParallelSection()
+	{
+		if (!parallel) return;
+		EndParallel();
+		Manager().EndConcurrent();
+	}
+};
+
+ROBDD AND(ROBDD robdd1, ROBDD robdd2)
+{
+	STAT_SCOPE(STAT_AND);
+	Manager().MaybeCollect();
+	ROBDD ret;
+	ParallelSection section;
+	ret.root = And(robdd1.root, robdd2.root);
+	return ret;
+}
+
+ROBDD OR(ROBDD robdd1, ROBDD robdd2)
+{
+	STAT_SCOPE(STAT_OR);
+	Manager().MaybeCollect();
+	ROBDD ret;
+	ParallelSection section;
+	ret.root = Or(robdd1.root, robdd2.root);
+	return ret;
+}
+
+ROBDD IMPLY(ROBDD robdd1, ROBDD robdd2)
+{
+	STAT_SCOPE(STAT_IMPLY);
+	Manager().MaybeCollect();
+	ROBDD ret;
+	ParallelSection section;
+	ret.root = Complement(And(robdd1.root, Complement(robdd2.root))); //p->q = NOT(p AND NOT q)
+	return ret;
+}
+
+ROBDD NOT(ROBDD robdd)
+{
+	ROBDD ret;
+	ret.root = Complement(robdd.root);
+	return ret;
+}
+
+ROBDD ITE(ROBDD robdd1, ROBDD robdd2, ROBDD robdd3)
+{
+	STAT_SCOPE(STAT_ITE);
+	Manager().MaybeCollect();
+	ROBDD ret;
+	ParallelSection section;
+	ret.root = ITE(robdd1.root, robdd2.root, robdd3.root);
+	return ret;
+}
+
+ROBDD EXISTS(ROBDD robdd, vector<int> vars)
+{
+	STAT_SCOPE(STAT_EXISTS);
+	Manager().MaybeCollect();
+	ROBDD cube;
+	cube.root = Cube(vars);
+	ROBDD ret;
+	ParallelSection section;
+	ret.root = Exists(robdd.root, cube.root);
+	return ret;
+}
+
+ROBDD FORALL(ROBDD robdd, vector<int> vars)
+{
+	return NOT(EXISTS(NOT(robdd), vars));
+}
+
+ROBDD AND_EXISTS(ROBDD robdd1, ROBDD robdd2, vector<int> vars)
+{
+	STAT_SCOPE(STAT_AND_EXISTS);
+	Manager().MaybeCollect();
+	ROBDD cube;
+	cube.root = Cube(vars);
+	ROBDD ret;
+	ParallelSection section;
+	ret.root = AndExists(robdd1.root, robdd2.root, cube.root);
+	return ret;
+}
+
+ROBDD RESTRICT(ROBDD robdd, int var, int value)
+{
+	STAT_SCOPE(STAT_RESTRICT);
+	Manager().MaybeCollect();
+	ROBDD ret;
+	ret.root = Restrict(robdd.root, value ? Var(var) : Complement(Var(var)));
+	return ret;
+}
+
+ROBDD COMPOSE(ROBDD robdd, int var, ROBDD g)
+{
+	STAT_SCOPE(STAT_COMPOSE);
+	Manager().MaybeCollect();
+	ROBDD high, low;
+	high.root = Restrict(robdd.root, Var(var));
+	low.root = Restrict(robdd.root, Complement(Var(var)));
+	ROBDD ret;
+	ret.root = ITE(g.root, high.root, low.root);
+	return ret;
+}
+
+ROBDD RENAME(ROBDD robdd, vector<int> permutation)
+{
+	STAT_SCOPE(STAT_RENAME);
+	Manager().MaybeCollect();
+	unordered_map<ROBDDRef, ROBDDRef> renamed;
+	ROBDD ret;
+	ret.root = Rename(robdd.root, permutation, renamed);
+	return ret;
+}
+
+static size_t partition_threshold = 0;
+static size_t explicit_cutoff = 1 << 12;
+
+void InterleaveOrder(int depth)
+{
+	if (depth < 2) return;
+	vector<int> order;
+	for (int i = 0; i < depth; i++)
+	{
+		if (Manager().Level(i) != i || Manager().Level(depth + i) != depth + i) return;
+		order.push_back(i);
+		order.push_back(depth + i);
+	}
+	Manager().SetOrder(order);
+}
+
+void SetPartitionThreshold(size_t nodes)
+{
+	partition_threshold = nodes;
+}
+
+size_t PartitionThreshold()
+{
+	return partition_threshold;
+}
+
+void SetExplicitCutoff(size_t nodes)
+{
+	explicit_cutoff = nodes;
+}
+
+size_t ExplicitCutoff()
+{
+	return explicit_cutoff;
+}
+
+TransitionRelation::TransitionRelation()
+{
+	depth = 0;
+	revision = -1;
+	threshold = 0;
+}
+
+void TransitionRelation::FromGraph(const Graph& G, size_t threshold)
+{
+	depth = G.Depth();
+	revision = G.revision;
+	this->threshold = threshold;
+	blocks.clear();
+	AddBlock(G, 0, G.num_nodes);
+}
+
+void TransitionRelation::AddBlock(const Graph& G, int first, int last)
+{
+	vector<unsigned long long> edges;
+	for (int i = first; i < last; i++)
+	{
+		const int* successors = G.Successors(i);
+		for (int j = 0; j < G.OutDegree(i); j++) edges.push_back((unsigned long long)i << depth | successors[j]);
+	}
+	if (edges.empty()) return;
+	RelationCluster cluster;
+	cluster.relation.root = FromPaths(edges, depth * 2);
+	if (threshold != 0 && last - first > 1 && cluster.relation.NodeCount() > threshold) //too big, split the sources in half
+	{
+		int middle = (first + last) / 2;
+		AddBlock(G, first, middle);
+		AddBlock(G, middle, last);
+		return;
+	}
+	cluster.quantify.root = Cube(depth, depth);
+	cluster.image_quantify.root = Cube(0, depth);
+	blocks.push_back(vector<RelationCluster>(1, cluster));
+}
+
+void TransitionRelation::FromConjuncts(vector<ROBDD> conjuncts, int depth, size_t threshold)
+{
+	this->depth = depth;
+	revision = -1;
+	this->threshold = threshold;
+	blocks.assign(1, vector<RelationCluster>());
+	vector<RelationCluster>& clusters = blocks[0];
+	ROBDD current;
+	current.FromConstant(1);
+	for (int i = 0; i < conjuncts.size(); i++) //greedily conjoin neighbours while the cluster stays under the threshold
+	{
+		ROBDD merged = AND(current, conjuncts[i]);
+		if (current.root == ROBDD_TRUE || threshold == 0 || merged.NodeCount() <= threshold)
+		{
+			current = merged;
+			continue;
+		}
+		clusters.push_back(RelationCluster());
+		clusters.back().relation = current;
+		current = conjuncts[i];
+	}
+	clusters.push_back(RelationCluster());
+	clusters.back().relation = current;
+	vector<int> last_use(depth * 2, 0); //each variable is quantified after the last cluster that mentions it
+	for (int i = 0; i < clusters.size(); i++)
+	{
+		vector<int> support = clusters[i].relation.Support();
+		for (int j = 0; j < support.size(); j++)
+		{
+			if (support[j] < depth * 2) last_use[support[j]] = i;
+		}
+	}
+	for (int i = 0; i < clusters.size(); i++)
+	{
+		vector<int> vars, image_vars;
+		for (int j = 0; j < depth; j++)
+		{
+			if (last_use[depth + j] == i) vars.push_back(depth + j);
+			if (last_use[j] == i) image_vars.push_back(j);
+		}
+		clusters[i].quantify.root = Cube(vars);
+		clusters[i].image_quantify.root = Cube(image_vars);
+	}
+}
+
+ROBDD TransitionRelation::PreImage(ROBDD states)
+{
+	ROBDD all;
+	all.FromConstant(1);
+	return PreImage(states, all);
+}
+
+ROBDD TransitionRelation::PreImage(ROBDD states, ROBDD within)
+{
+	STAT_SCOPE(STAT_PREIMAGE);
+	vector<int> permutation;
+	for (int i = 0; i < depth; i++) permutation.push_back(depth + i);
+	ROBDD next_states = AND(RENAME(states, permutation), within); //within only mentions current-state variables, so it can go in first and prune every product
+	ROBDD ret, product;
+	for (int i = 0; i < blocks.size(); i++)
+	{
+		product = next_states;
+		for (int j = 0; j < blocks[i].size(); j++)
+		{
+			Manager().MaybeCollect();
+			ParallelSection section;
+			product.root = AndExists(product.root, blocks[i][j].relation.root, blocks[i][j].quantify.root);
+		}
+		ret = OR(ret, product);
+	}
+	return ret;
+}
+
+ROBDD TransitionRelation::Image(ROBDD states, ROBDD within)
+{
+	STAT_SCOPE(STAT_IMAGE);
+	vector<int> permutation; //x_(depth+i) back to x_i
+	for (int i = 0; i < depth; i++) permutation.push_back(depth + i);
+	for (int i = 0; i < depth; i++) permutation.push_back(i);
+	ROBDD ret, product;
+	for (int i = 0; i < blocks.size(); i++)
+	{
+		product = states;
+		for (int j = 0; j < blocks[i].size(); j++)
+		{
+			Manager().MaybeCollect();
+			ParallelSection section;
+			product.root = AndExists(product.root, blocks[i][j].relation.root, blocks[i][j].image_quantify.root);
+		}
+		ret = OR(ret, product);
+	}
+	return AND(RENAME(ret, permutation), within);
+}
+
+static TransitionRelation& Relation(const Graph& G) //the relation is built once per revision of the graph
+{
+	static TransitionRelation cached;
+	if (cached.revision != G.revision || cached.threshold != partition_threshold) cached.FromGraph(G, partition_threshold);
+	return cached;
+}
+
+static void TraceSet(const char* name, int epoch, ROBDD& robdd)
+{
+	if (!Tracing(TRACE_SETS)) return;
+	TraceStream() << "\n" << name;
+	if (epoch >= 0) TraceStream() << epoch;
+	TraceStream() << ":\n";
+	robdd.Print(TraceStream());
+}
+
+ROBDD EG(const Graph& G, ROBDD robdd)
+{
+	return EG(G, robdd, vector<ROBDD>());
+}
+
+ROBDD EG(const Graph& G, ROBDD robdd, const vector<ROBDD>& fairness)
+{
+	if (G.num_nodes <= explicit_cutoff) //a linear scan of a small graph beats any symbolic SCC search
+	{
+		vector<StateSet> fair_sets;
+		for (int i = 0; i < fairness.size(); i++) fair_sets.push_back(ToStateSet(fairness[i], G.num_nodes, G.Depth()));
+		return ToROBDD(EG(G, ToStateSet(robdd, G.num_nodes, G.Depth()), fair_sets), G.Depth());
+	}
+	return EG(Relation(G), robdd, fairness);
+}
+
+static ROBDD Trim(TransitionRelation& R, ROBDD states) //drops states without a successor or a predecessor in the set until there are none, they lie on no cycle
+{
+	ROBDD candidates = states; //only neighbours of dropped states can lose their last successor or predecessor
+	while (candidates.root != ROBDD_FALSE)
+	{
+		ROBDD dead = AND(candidates, NOT(AND(R.PreImage(states, candidates), R.Image(states, candidates))));
+		if (dead.root == ROBDD_FALSE) break;
+		states = AND(states, NOT(dead));
+		candidates = OR(R.PreImage(dead, states), R.Image(dead, states));
+	}
+	return states;
+}
+
+static ROBDD FairCycles(TransitionRelation& R, ROBDD states, const vector<ROBDD>& fairness) //union of the nontrivial SCCs within states that meet every fairness set, by lockstep search
+{
+	ROBDD ret;
+	vector<ROBDD> pending(1, states); //sets no SCC crosses the boundary of
+	int found = 0;
+	while (!pending.empty())
+	{
+		ROBDD V = Trim(R, pending.back());
+		pending.pop_back();
+		if (V.root == ROBDD_FALSE) continue;
+		ROBDD seed = V.PickOne(R.depth);
+		ROBDD forward = seed, backward = seed, forward_frontier = seed, backward_frontier = seed;
+		while (forward_frontier.root != ROBDD_FALSE && backward_frontier.root != ROBDD_FALSE) //both searches step together until one is closed
+		{
+			forward_frontier = AND(R.Image(forward_frontier, V), NOT(forward));
+			forward = OR(forward, forward_frontier);
+			backward_frontier = AND(R.PreImage(backward_frontier, V), NOT(backward));
+			backward = OR(backward, backward_frontier);
+		}
+		ROBDD converged;
+		if (forward_frontier.root == ROBDD_FALSE) //the SCC lies inside the forward set, finish the backward search there
+		{
+			converged = forward;
+			backward_frontier = AND(backward_frontier, forward);
+			while (backward_frontier.root != ROBDD_FALSE)
+			{
+				backward_frontier = AND(R.PreImage(backward_frontier, forward), NOT(backward));
+				backward = OR(backward, backward_frontier);
+			}
+		}
+		else
+		{
+			converged = backward;
+			forward_frontier = AND(forward_frontier, backward);
+			while (forward_frontier.root != ROBDD_FALSE)
+			{
+				forward_frontier = AND(R.Image(forward_frontier, backward), NOT(forward));
+				forward = OR(forward, forward_frontier);
+			}
+		}
+		ROBDD scc = AND(forward, backward);
+		bool fair = scc.root != seed.root || R.Image(seed, seed).root != ROBDD_FALSE; //a single state needs a self loop
+		for (int i = 0; i < fairness.size() && fair; i++) fair = AND(scc, fairness[i]).root != ROBDD_FALSE;
+		TraceSet("SCC", found++, scc);
+		if (fair) ret = OR(ret, scc);
+		pending.push_back(AND(converged, NOT(scc)));
+		pending.push_back(AND(V, NOT(converged)));
+	}
+	return ret;
+}
+
+ROBDD EG(TransitionRelation& R, ROBDD robdd)
+{ //greatest fixpoint of Z = robdd AND pre(Z), only states whose successors just left Z are checked again
+	STAT_SCOPE(STAT_EG);
+	STAT_FIXPOINT(STAT_EG);
+	if (Tracing(TRACE_STEPS)) TraceStream() << "\nImplementing EG...\n";
+	ROBDD tn = robdd;
+	ROBDD frontier = robdd; //every state of tn outside the frontier has a successor in tn
+	int epoch = 0;
+	while (1)
+	{
+		STAT_FRONTIER(frontier);
+		if (Tracing(TRACE_STEPS)) TraceStream() << "\nEpoch " << epoch << '\n';
+		TraceSet("t", epoch, tn);
+		ROBDD SPe = R.PreImage(tn, frontier);
+		TraceSet("SPe", -1, SPe);
+		ROBDD V = AND(frontier, NOT(SPe)); //states left without a successor in tn
+		TraceSet("V", -1, V);
+		if (V.root == ROBDD_FALSE)
+		{
+			if (Tracing(TRACE_STEPS)) TraceStream() << "\ntn=tn-1\n";
+			break;
+		}
+		tn = AND(tn, NOT(V));
+		frontier = R.PreImage(V, tn);
+		epoch++;
+	}
+	FlushTrace();
+	return tn;
+}
+
+ROBDD EG(TransitionRelation& R, ROBDD robdd, const vector<ROBDD>& fairness)
+{ //states of robdd that reach, within robdd, a nontrivial SCC of robdd meeting every fairness set
+	if (fairness.empty()) return EG(R, robdd); //trimming the states without a successor already leaves the answer
+	STAT_SCOPE(STAT_EG);
+	if (Tracing(TRACE_STEPS)) TraceStream() << "\nImplementing EG by SCC decomposition...\n";
+	ROBDD cycles = FairCycles(R, robdd, fairness);
+	TraceSet("cycles", -1, cycles);
+	FlushTrace();
+	return EU(R, robdd, cycles);
+}
+
+ROBDD EX(const Graph& G, ROBDD robdd)
+{
+	TransitionRelation& R = Relation(G);
+	return EX(R, robdd);
+}
+
+ROBDD EX(TransitionRelation& R, ROBDD robdd)
+{ //V = {s | ∃t ∈ U : s → t}
+	STAT_SCOPE(STAT_EX);
+	if (Tracing(TRACE_STEPS)) TraceStream() << "\nImplementing EX...\n";
+	ROBDD V = R.PreImage(robdd);
+	TraceSet("V", -1, V);
+	FlushTrace();
+	return V;
+}
+
+ROBDD EU(const Graph& G, ROBDD robdd1, ROBDD robdd2)
+{
+	TransitionRelation& R = Relation(G);
+	return EU(R, robdd1, robdd2);
+}
+
+ROBDD EU(const Graph& G, ROBDD robdd1, ROBDD robdd2, OnionRings* rings)
+{
+	TransitionRelation& R = Relation(G);
+	return EU(R, robdd1, robdd2, rings);
+}
+
+ROBDD EU(TransitionRelation& R, ROBDD robdd1, ROBDD robdd2)
+{
+	return EU(R, robdd1, robdd2, NULL);
+}
+
+ROBDD EU(TransitionRelation& R, ROBDD robdd1, ROBDD robdd2, OnionRings* rings)
+{ //least fixpoint of Z = robdd2 OR (robdd1 AND pre(Z)), only the states added last epoch are expanded
+	STAT_SCOPE(STAT_EU);
+	STAT_FIXPOINT(STAT_EU);
+	if (Tracing(TRACE_STEPS)) TraceStream() << "\nImplementing EU...\n";
+	ROBDD T = robdd1;
+	ROBDD un = robdd2;
+	ROBDD frontier = robdd2;
+	int epoch = 0;
+	if (rings != NULL)
+	{
+		*rings = OnionRings(rings->budget);
+		rings->within = robdd1;
+		rings->target = robdd2;
+		rings->Keep(robdd2);
+	}
+	while (1)
+	{
+		STAT_FRONTIER(frontier);
+		if (Tracing(TRACE_STEPS)) TraceStream() << "\nEpoch " << epoch << '\n';
+		TraceSet("u", epoch, un);
+		ROBDD SPe = R.PreImage(frontier, AND(T, NOT(un)));
+		TraceSet("SPe", -1, SPe);
+		if (SPe.root == ROBDD_FALSE)
+		{
+			if (Tracing(TRACE_STEPS)) TraceStream() << "\nun=un-1\n";
+			break;
+		}
+		un = OR(un, SPe);
+		frontier = SPe;
+		if (rings != NULL) rings->Keep(SPe);
+		epoch++;
+	}
+	FlushTrace();
+	return un;
+}
+
+OnionRings::OnionRings(size_t budget)
+{
+	this->budget = budget;
+	nodes = 0;
+	complete = true;
+}
+
+void OnionRings::Keep(ROBDD ring)
+{
+	if (!complete) return;
+	nodes += ring.NodeCount();
+	if (budget != 0 && nodes > budget)
+	{
+		rings.clear();
+		complete = false;
+		return;
+	}
+	rings.push_back(ring);
+}
+
+static vector<ROBDD> ShortestPath(TransitionRelation& R, ROBDD from, ROBDD to, ROBDD within) //from a state of from to one of to through states of within, by forward BFS, empty if there is none
+{
+	vector<ROBDD> layers; //states first reached by each step, none of them in to
+	ROBDD open = OR(within, to);
+	ROBDD reached = AND(from, open);
+	ROBDD layer = reached;
+	while (layer.root != ROBDD_FALSE && AND(layer, to).root == ROBDD_FALSE)
+	{
+		layers.push_back(layer);
+		layer = AND(R.Image(AND(layer, within), open), NOT(reached));
+		reached = OR(reached, layer);
+	}
+	vector<ROBDD> ret;
+	if (layer.root == ROBDD_FALSE) return ret;
+	ret.push_back(AND(layer, to).PickOne(R.depth));
+	for (int i = layers.size() - 1; i >= 0; i--) ret.push_back(R.PreImage(ret.back(), AND(layers[i], within)).PickOne(R.depth)); //back through the layers
+	reverse(ret.begin(), ret.end());
+	return ret;
+}
+
+static ROBDD Closure(TransitionRelation& R, ROBDD states, ROBDD within, bool forward) //states plus whatever they reach inside within, or whatever reaches them
+{
+	ROBDD frontier = states;
+	while (frontier.root != ROBDD_FALSE)
+	{
+		frontier = AND(forward ? R.Image(frontier, within) : R.PreImage(frontier, within), NOT(states));
+		states = OR(states, frontier);
+	}
+	return states;
+}
+
+vector<ROBDD> Witness(const Graph& G, const OnionRings& rings, ROBDD start)
+{
+	return Witness(Relation(G), rings, start);
+}
+
+vector<ROBDD> Witness(TransitionRelation& R, const OnionRings& rings, ROBDD start)
+{ //a state of ring k has a successor in ring k-1, and none in an earlier one
+	if (!rings.complete) return ShortestPath(R, start, rings.target, rings.within);
+	vector<ROBDD> ret;
+	int k = 0;
+	while (k < rings.rings.size() && AND(start, rings.rings[k]).root == ROBDD_FALSE) k++;
+	if (k == rings.rings.size()) return ret;
+	ret.push_back(AND(start, rings.rings[k]).PickOne(R.depth));
+	for (k--; k >= 0; k--) ret.push_back(R.Image(ret.back(), rings.rings[k]).PickOne(R.depth));
+	return ret;
+}
+
+vector<ROBDD> Lasso(const Graph& G, ROBDD robdd, const vector<ROBDD>& fairness, ROBDD start, size_t budget)
+{
+	return Lasso(Relation(G), robdd, fairness, start, budget);
+}
+
+vector<ROBDD> Lasso(TransitionRelation& R, ROBDD robdd, const vector<ROBDD>& fairness, ROBDD start, size_t budget)
+{ //a shortest prefix to a fair SCC, then shortest hops inside it through each fairness set and back
+	if (Tracing(TRACE_STEPS)) TraceStream() << "\nBuilding a lasso for EG...\n";
+	ROBDD cycles = FairCycles(R, robdd, fairness);
+	OnionRings rings(budget);
+	ROBDD satisfied = EU(R, robdd, cycles, &rings);
+	vector<ROBDD> ret = Witness(R, rings, AND(start, satisfied));
+	if (ret.empty()) return ret;
+	ROBDD entry = ret.back();
+	ROBDD scc = AND(Closure(R, entry, cycles, true), Closure(R, entry, cycles, false));
+	TraceSet("SCC", -1, scc);
+	for (int i = 0; i < fairness.size(); i++)
+	{
+		vector<ROBDD> hop = ShortestPath(R, ret.back(), AND(scc, fairness[i]), scc);
+		ret.insert(ret.end(), hop.begin() + 1, hop.end());
+	}
+	vector<ROBDD> back = ShortestPath(R, R.Image(ret.back(), scc), entry, scc); //at least one step, the SCC is nontrivial
+	ret.insert(ret.end(), back.begin(), back.end());
+	FlushTrace();
+	return ret;
+}
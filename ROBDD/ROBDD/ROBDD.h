@@ -1,41 +1,147 @@
-#pragma once
-#include<vector>
-#include"Graph.h"
-using namespace std;
-struct ROBDDNode
-{
-	int label; //-1 for leaf
-	union
-	{
-		struct
-		{
-			ROBDDNode* true_branch;
-			ROBDDNode* false_branch;
-		}successor;
-		int value;
-	}value;
-};
-ROBDDNode* Clone(ROBDDNode* src);
-bool Contain(ROBDDNode* node, int label);
-class ROBDD
-{
-public:
-	ROBDDNode* root;
-	vector<ROBDDNode*> nodes;
-	void ConvertFromGraph(Graph graph);
-	void FromTrueValueVector(vector<int> TrueValues);
-	void Simplify();
-	void Print();
-	ROBDD CloneROBDD();
-	bool Walk(int path, int pathlen); //walk down the path, see if it ends.
-};
-vector<ROBDDNode*> NodeVector(ROBDDNode* StartVector);
-bool Equal(ROBDDNode* node1, ROBDDNode* node2);
-ROBDD AND(ROBDD robdd1, ROBDD robdd2);
-ROBDD OR(ROBDD robdd1, ROBDD robdd2);
-ROBDD IMPLY(ROBDD robdd1, ROBDD robdd2);
-ROBDD NOT(ROBDD robdd);
-ROBDD EX(Graph G, ROBDD robdd);
-ROBDD EG(Graph G, ROBDD robdd);
-ROBDD EU(Graph G, ROBDD robdd1, ROBDD robdd2);
-
+#pragma once
+#include<vector>
+#include<ostream>
+#include<string>
+#include<cstdint>
+#include"Graph.h"
+#include"ROBDDManager.h"
+using namespace std;
+class ROBDD
+{
+public:
+	ROBDDRef root; //shared with every other ROBDD representing the same function
+	ROBDD(); //the constant False
+	ROBDD(const ROBDD& other);
+	ROBDD& operator=(const ROBDD& other);
+	~ROBDD();
+	void ConvertFromGraph(const Graph& graph);
+	void FromTrueValueVector(const vector<int>& TrueValues);
+	void FromTrueValueVector(const vector<int>& TrueValues, int depth); //states encoded with depth bits, as in a graph of that depth
+	void FromTrueValueVector(const vector<unsigned long long>& TrueValues, int depth); //the same with 64-bit states, bits past the 64th are 0
+	void FromCubes(const vector<vector<signed char> >& cubes); //the OR of the cubes, as CubeIterator gives them, so states of any width
+	void FromRange(unsigned long long first, unsigned long long last, int depth); //states first..last, both included
+	void FromConstant(int value);
+	void Simplify(); //no-op, diagrams are reduced by construction
+	void Print();
+	void Print(ostream& out);
+	int NodeCount(); //leaf included
+	vector<int> Support(); //labels the function depends on, ascending
+	double SatCount(int nvars); //satisfying assignments of x_0..x_(nvars-1), one memoized pass, variables past them are averaged over
+	string ExactSatCount(int nvars); //the same in decimal, exact whatever nvars is
+	ROBDD PickOne(int nvars); //one satisfying assignment of x_0..x_(nvars-1) as a minterm, False if there is none
+	ROBDD CloneROBDD();
+	bool Walk(unsigned long long path, int pathlen); //walk down the path, see if it ends.
+	bool Walk(const vector<unsigned long long>& path, int pathlen); //a path wider than 64 bits, most significant word first
+	void Walk(const uint64_t* paths, size_t count, int pathlen, uint64_t* result); //the same for many paths, 64 per pass, bit i of result[i / 64] for paths[i]
+private:
+	friend class ROBDDManager;
+	ROBDD* prev_handle;
+	ROBDD* next_handle;
+};
+class BatchEvaluator //the diagram of an ROBDD flattened once, then queried 64 assignments per pass without allocating
+{
+public:
+	BatchEvaluator(ROBDD robdd);
+	uint64_t Evaluate(const uint64_t* slices, int nvars); //bit j tells whether assignment j reaches True, slices[l] holds x_l of each. As in Walk, reaching a variable past nvars counts as True
+	void Evaluate(const uint64_t* states, size_t count, int depth, uint64_t* result); //states are indices, x_0 being the most significant of depth bits, depth at most 64
+private:
+	struct FlatNode
+	{
+		int label;
+		int level; //in the variable order, the leaf one past the last variable
+		int children[2]; //false and true child, index << 1 | complement
+	};
+	ROBDD robdd; //keeps the nodes alive
+	vector<FlatNode> nodes; //by level, so parents come first, the leaf is last
+	int root; //index << 1 | complement
+	vector<uint64_t> masks; //scratch, two per node: the assignments reaching it with even and odd parity of complements
+	vector<vector<int> > active; //scratch, nodes reached in the current pass by level
+};
+class CubeIterator //the paths of an ROBDD to True, one at a time, the ROBDD must not be reordered meanwhile
+{
+public:
+	CubeIterator(ROBDD robdd, int nvars);
+	bool Next(); //moves to the next cube, false once there are none left
+	const vector<signed char>& Cube() { return cube; } //value of x_0..x_(nvars-1) on the path, -1 where the path does not test it
+private:
+	ROBDD robdd;
+	vector<signed char> cube;
+	vector<pair<ROBDDRef, bool> > frames; //the nodes of the path and whether their false branch was taken
+	bool started;
+};
+class StateIterator //the states of an ROBDD, x_0 being the most significant bit of the index, depth at most 64
+{
+public:
+	StateIterator(ROBDD robdd, int depth);
+	bool Next(unsigned long long& state); //false once there are none left
+private:
+	CubeIterator cubes;
+	int depth;
+	unsigned long long value, free, sub; //the states of the current cube are value plus each subset of the free bits
+	bool in_cube;
+};
+struct RelationCluster
+{
+	ROBDD relation;
+	ROBDD quantify; //next-state variables no later cluster of the block mentions
+	ROBDD image_quantify; //current-state variables no later cluster of the block mentions
+};
+class TransitionRelation //s -> t over x_0..x_(depth-1) for s and x_depth..x_(2depth-1) for t
+{
+public:
+	int depth;
+	long long revision; //revision of the graph the relation was built from
+	size_t threshold; //node cap of a cluster, 0 keeps the relation in one piece
+	vector<vector<RelationCluster> > blocks; //the relation is the OR over blocks of the AND of their clusters
+	TransitionRelation();
+	void FromGraph(const Graph& G, size_t threshold);
+	void FromConjuncts(vector<ROBDD> conjuncts, int depth, size_t threshold);
+	ROBDD PreImage(ROBDD states); //states with a successor in states
+	ROBDD PreImage(ROBDD states, ROBDD within); //states of within with a successor in states
+	ROBDD Image(ROBDD states, ROBDD within); //successors of states that lie in within
+private:
+	void AddBlock(const Graph& G, int first, int last); //edges leaving nodes first..last-1
+};
+struct OnionRings //what EU keeps for witnesses when asked: ring k holds the states its epoch k added, k steps from the target
+{
+	ROBDD within, target; //robdd1 and robdd2 of the EU
+	vector<ROBDD> rings; //ring 0 is the target
+	size_t budget; //node cap over all rings, 0 for none
+	size_t nodes; //nodes of the rings kept so far, shared ones counted once per ring
+	bool complete; //false once the cap was hit, the rings are then dropped and witnesses search forward instead
+	OnionRings(size_t budget = 0);
+	void Keep(ROBDD ring);
+};
+void InterleaveOrder(int depth); //x_i and its next-state copy x_(depth+i) side by side, as relations want, unless the order was already changed. Moves every live ROBDD, so call it once when the model is loaded
+void SetPartitionThreshold(size_t nodes); //cluster cap for the relations of EX/EG/EU, 0 for monolithic relations
+size_t PartitionThreshold();
+void SetExplicitCutoff(size_t nodes); //EG on graphs up to this many nodes runs Tarjan's algorithm on the graph itself
+size_t ExplicitCutoff();
+vector<ROBDDRef> NodeVector(ROBDDRef StartVector);
+bool Equal(ROBDDRef node1, ROBDDRef node2);
+ROBDD AND(ROBDD robdd1, ROBDD robdd2);
+ROBDD OR(ROBDD robdd1, ROBDD robdd2);
+ROBDD IMPLY(ROBDD robdd1, ROBDD robdd2);
+ROBDD NOT(ROBDD robdd);
+ROBDD ITE(ROBDD robdd1, ROBDD robdd2, ROBDD robdd3); //if robdd1 then robdd2 else robdd3
+ROBDD EXISTS(ROBDD robdd, vector<int> vars);
+ROBDD FORALL(ROBDD robdd, vector<int> vars);
+ROBDD AND_EXISTS(ROBDD robdd1, ROBDD robdd2, vector<int> vars); //EXISTS(AND(robdd1, robdd2), vars) without building the conjunction
+ROBDD RESTRICT(ROBDD robdd, int var, int value); //x_var fixed to value
+ROBDD COMPOSE(ROBDD robdd, int var, ROBDD g); //x_var replaced by g
+ROBDD RENAME(ROBDD robdd, vector<int> permutation); //x_i becomes x_permutation[i], variables past the end are kept
+ROBDD EX(const Graph& G, ROBDD robdd);
+ROBDD EG(const Graph& G, ROBDD robdd);
+ROBDD EG(const Graph& G, ROBDD robdd, const vector<ROBDD>& fairness); //paths that visit every fairness set infinitely often
+ROBDD EU(const Graph& G, ROBDD robdd1, ROBDD robdd2);
+ROBDD EU(const Graph& G, ROBDD robdd1, ROBDD robdd2, OnionRings* rings); //also fills rings unless it is NULL
+ROBDD EX(TransitionRelation& R, ROBDD robdd); //same, with a relation built by the caller
+ROBDD EG(TransitionRelation& R, ROBDD robdd);
+ROBDD EG(TransitionRelation& R, ROBDD robdd, const vector<ROBDD>& fairness);
+ROBDD EU(TransitionRelation& R, ROBDD robdd1, ROBDD robdd2);
+ROBDD EU(TransitionRelation& R, ROBDD robdd1, ROBDD robdd2, OnionRings* rings);
+//Paths are lists of minterms over x_0..x_(depth-1), one per state, and are empty when no state of start qualifies
+vector<ROBDD> Witness(const Graph& G, const OnionRings& rings, ROBDD start);
+vector<ROBDD> Witness(TransitionRelation& R, const OnionRings& rings, ROBDD start); //a shortest path from a state of start satisfying the EU to its target, through within
+vector<ROBDD> Lasso(const Graph& G, ROBDD robdd, const vector<ROBDD>& fairness, ROBDD start, size_t budget = 0);
+vector<ROBDD> Lasso(TransitionRelation& R, ROBDD robdd, const vector<ROBDD>& fairness, ROBDD start, size_t budget = 0); //a path of robdd states from a state of start into a cycle visiting every fairness set, the last state repeats the first state of the cycle
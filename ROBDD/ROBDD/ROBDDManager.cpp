@@ -0,0 +1,692 @@
+#include "ROBDDManager.h"
+#include "ROBDD.h"
+#include "Stats.h"
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#endif
+#include <chrono>
+#include <algorithm>
+#include <cassert>
+
+ROBDDManager::ROBDDManager()
+{
+	pages.assign(MAX_PAGES, NULL);
+	num_pages = 0;
+	top = 0;
+	free_list = ROBDD_NULL;
+	concurrent = 0;
+	alloc_epoch = 0;
+	num_nodes = peak_nodes = nodes_allocated = nodes_freed = 0;
+	cache_hits = cache_misses = 0;
+	handles = NULL;
+	gc_threshold = 1 << 20;
+	gc_runs = 0;
+	auto_reorder = false;
+	reorder_threshold = MIN_REORDER_NODES;
+	reorder_runs = reorder_before = reorder_after = 0;
+	reorder_seconds = 0;
+	stamp = 0;
+	ClearBuckets(1 << 12);
+	SetCacheSize(1 << 16);
+	ROBDDNode& leaf = Slot(AllocNode()); //arena index 0, so ROBDD_TRUE is its regular edge
+	leaf.label = -1;
+	leaf.true_branch = leaf.false_branch = leaf.next = ROBDD_NULL;
+}
+
+ROBDDRef ROBDDManager::Leaf(int value)
+{
+	return value != 0 ? ROBDD_TRUE : ROBDD_FALSE;
+}
+
+void ROBDDManager::NewPage()
+{
+	pages[num_pages++] = new ROBDDNode[PAGE_MASK + 1];
+}
+
+static thread_local vector<ROBDDRef> local_free; //free slots this thread took while concurrent
+static thread_local size_t local_epoch;
+
+ROBDDRef ROBDDManager::AllocNode()
+{
+	ROBDDRef ret;
+	if (concurrent)
+	{
+		if (local_epoch != alloc_epoch)
+		{
+			local_free.clear();
+			local_epoch = alloc_epoch;
+		}
+		if (local_free.empty())
+		{
+			lock_guard<mutex> lock(alloc_mutex);
+			while (local_free.size() < ALLOC_BATCH && free_list != ROBDD_NULL)
+			{
+				local_free.push_back(free_list);
+				free_list = Slot(free_list).next;
+			}
+			while (local_free.size() < ALLOC_BATCH)
+			{
+				if ((top >> PAGE_BITS) == num_pages) NewPage();
+				Slot(top).label = -2;
+				local_free.push_back(top++);
+			}
+		}
+		ret = local_free.back();
+		local_free.pop_back();
+	}
+	else if (free_list != ROBDD_NULL)
+	{
+		ret = free_list;
+		free_list = Slot(ret).next;
+	}
+	else
+	{
+		if ((top >> PAGE_BITS) == num_pages) NewPage();
+		ret = top++;
+	}
+	nodes_allocated++;
+	size_t live = ++num_nodes;
+	if (live > peak_nodes.load(memory_order_relaxed)) peak_nodes.store(live, memory_order_relaxed);
+	return ret;
+}
+
+void ROBDDManager::ReleaseNode(ROBDDRef index)
+{
+	Slot(index).label = -2;
+	if (concurrent) local_free.push_back(index);
+	else
+	{
+		Slot(index).next = free_list;
+		free_list = index;
+	}
+	nodes_allocated--;
+	num_nodes--;
+}
+
+void ROBDDManager::ClearBuckets(size_t size)
+{
+	if (buckets.size() != size) vector<atomic<ROBDDRef> >(size).swap(buckets);
+	for (size_t i = 0; i < size; i++) buckets[i].store(ROBDD_NULL, memory_order_relaxed);
+}
+
+size_t ROBDDManager::BucketOf(int label, ROBDDRef true_branch, ROBDDRef false_branch)
+{
+	size_t h = (size_t)label * 12582917u;
+	h = (h ^ true_branch) * 4256249u;
+	h = (h ^ false_branch) * 741457u;
+	h ^= h >> 15;
+	return h & (buckets.size() - 1);
+}
+
+void ROBDDManager::ResizeTable()
+{
+	ClearBuckets(buckets.size() * 2);
+	for (ROBDDRef i = 1; i < top; i++)
+	{
+		ROBDDNode& node = Slot(i);
+		if (node.label < 0) continue;
+		size_t bucket = BucketOf(node.label, node.true_branch, node.false_branch);
+		node.next = buckets[bucket].load(memory_order_relaxed);
+		buckets[bucket].store(i << 1, memory_order_relaxed);
+	}
+}
+
+ROBDDRef ROBDDManager::MakeNode(int label, ROBDDRef true_branch, ROBDDRef false_branch)
+{
+	if (true_branch == false_branch) return true_branch; //the test is redundant
+	if (IsComplement(true_branch)) return Complement(MakeNode(label, Complement(true_branch), Complement(false_branch)));
+	if (label >= var_to_level.size()) AddVariables(label + 1);
+	size_t bucket = BucketOf(label, true_branch, false_branch);
+	ROBDDRef head = buckets[bucket].load(memory_order_acquire);
+	for (ROBDDRef i = head; i != ROBDD_NULL; i = Node(i).next)
+	{
+		ROBDDNode& node = Node(i);
+		if (node.label == label && node.true_branch == true_branch && node.false_branch == false_branch) return i;
+	}
+	ROBDDRef ret = AllocNode() << 1;
+	ROBDDNode& NewNode = Node(ret);
+	NewNode.label = label;
+	NewNode.true_branch = true_branch;
+	NewNode.false_branch = false_branch;
+	NewNode.next = head;
+	while (!buckets[bucket].compare_exchange_weak(head, ret, memory_order_release, memory_order_acquire))
+	{
+		for (ROBDDRef i = head; i != NewNode.next; i = Node(i).next) //another thread got in first, maybe with the same node
+		{
+			ROBDDNode& node = Node(i);
+			if (node.label == label && node.true_branch == true_branch && node.false_branch == false_branch)
+			{
+				ReleaseNode(ret >> 1);
+				return i;
+			}
+		}
+		NewNode.next = head;
+	}
+	if (!concurrent && num_nodes > buckets.size()) ResizeTable(); //the table only grows between concurrent sections
+	return ret;
+}
+
+size_t ROBDDManager::NumNodes()
+{
+	return num_nodes;
+}
+
+size_t ROBDDManager::CacheSlot(int op, ROBDDRef f, ROBDDRef g, ROBDDRef h)
+{
+	size_t x = (size_t)f * 12582917u;
+	x = (x ^ g) * 4256249u;
+	x = (x ^ h) * 1190494759u;
+	x = (x ^ op) * 741457u;
+	x ^= x >> 15;
+	return x & (cache.size() - 1);
+}
+
+bool ROBDDManager::CacheLookup(int op, ROBDDRef f, ROBDDRef g, ROBDDRef& result)
+{
+	return CacheLookup(op, f, g, ROBDD_TRUE, result);
+}
+
+bool ROBDDManager::CacheLookup(int op, ROBDDRef f, ROBDDRef g, ROBDDRef h, ROBDDRef& result)
+{
+	ROBDDCacheEntry& entry = cache[CacheSlot(op, f, g, h)];
+	unsigned version = entry.version.load(memory_order_acquire);
+	if ((version & 1) == 0 && entry.op.load(memory_order_relaxed) == op && entry.f.load(memory_order_relaxed) == f
+		&& entry.g.load(memory_order_relaxed) == g && entry.h.load(memory_order_relaxed) == h)
+	{
+		result = entry.result.load(memory_order_relaxed);
+		atomic_thread_fence(memory_order_acquire);
+		if (entry.version.load(memory_order_relaxed) == version) //nobody rewrote the entry while we read it
+		{
+			cache_hits.fetch_add(1, memory_order_relaxed);
+			return true;
+		}
+	}
+	cache_misses.fetch_add(1, memory_order_relaxed);
+	return false;
+}
+
+void ROBDDManager::CacheInsert(int op, ROBDDRef f, ROBDDRef g, ROBDDRef result)
+{
+	CacheInsert(op, f, g, ROBDD_TRUE, result);
+}
+
+void ROBDDManager::CacheInsert(int op, ROBDDRef f, ROBDDRef g, ROBDDRef h, ROBDDRef result)
+{
+	ROBDDCacheEntry& entry = cache[CacheSlot(op, f, g, h)];
+	unsigned version = entry.version.load(memory_order_relaxed);
+	if ((version & 1) != 0 || !entry.version.compare_exchange_strong(version, version + 1, memory_order_acq_rel)) return; //someone else is writing it, the cache is lossy anyway
+	atomic_thread_fence(memory_order_release);
+	entry.op.store(op, memory_order_relaxed);
+	entry.f.store(f, memory_order_relaxed);
+	entry.g.store(g, memory_order_relaxed);
+	entry.h.store(h, memory_order_relaxed);
+	entry.result.store(result, memory_order_relaxed);
+	entry.version.store(version + 2, memory_order_release);
+}
+
+void ROBDDManager::SetCacheSize(size_t entries)
+{
+	size_t size = 1;
+	while (size < entries) size <<= 1;
+	if (cache.size() != size) vector<ROBDDCacheEntry>(size).swap(cache);
+	for (size_t i = 0; i < size; i++)
+	{
+		cache[i].version.store(0, memory_order_relaxed);
+		cache[i].op.store(-1, memory_order_relaxed);
+		cache[i].f.store(ROBDD_NULL, memory_order_relaxed);
+		cache[i].g.store(ROBDD_NULL, memory_order_relaxed);
+		cache[i].h.store(ROBDD_NULL, memory_order_relaxed);
+		cache[i].result.store(ROBDD_NULL, memory_order_relaxed);
+	}
+}
+
+size_t ROBDDManager::CacheSize()
+{
+	return cache.size();
+}
+
+size_t ROBDDManager::CacheOccupancy()
+{
+	size_t ret = 0;
+	for (size_t i = 0; i < cache.size(); i++)
+	{
+		if (cache[i].op.load(memory_order_relaxed) != -1) ret++;
+	}
+	return ret;
+}
+
+size_t ROBDDManager::TableSize()
+{
+	return buckets.size();
+}
+
+size_t ROBDDManager::TableOccupancy()
+{
+	size_t ret = 0;
+	for (size_t i = 0; i < buckets.size(); i++)
+	{
+		if (buckets[i].load(memory_order_relaxed) != ROBDD_NULL) ret++;
+	}
+	return ret;
+}
+
+vector<size_t> ROBDDManager::NodesPerLevel()
+{
+	vector<size_t> ret(var_to_level.size(), 0);
+	for (ROBDDRef i = 1; i < top; i++)
+	{
+		int label = Slot(i).label;
+		if (label >= 0) ret[var_to_level[label]]++;
+	}
+	return ret;
+}
+
+size_t ROBDDManager::CacheHits()
+{
+	return cache_hits;
+}
+
+size_t ROBDDManager::CacheMisses()
+{
+	return cache_misses;
+}
+
+void ROBDDManager::Register(ROBDD* robdd)
+{
+	unique_lock<mutex> lock(handle_mutex, defer_lock);
+	if (concurrent) lock.lock();
+	robdd->prev_handle = NULL;
+	robdd->next_handle = handles;
+	if (handles != NULL) handles->prev_handle = robdd;
+	handles = robdd;
+}
+
+void ROBDDManager::Unregister(ROBDD* robdd)
+{
+	unique_lock<mutex> lock(handle_mutex, defer_lock);
+	if (concurrent) lock.lock();
+	if (robdd->prev_handle != NULL) robdd->prev_handle->next_handle = robdd->next_handle;
+	else handles = robdd->next_handle;
+	if (robdd->next_handle != NULL) robdd->next_handle->prev_handle = robdd->prev_handle;
+}
+
+void ROBDDManager::MaybeCollect()
+{
+	if (concurrent) return; //other threads hold nodes in flight
+	if (auto_reorder && num_nodes >= reorder_threshold)
+	{
+		Reorder();
+		return;
+	}
+	if (num_nodes < gc_threshold) return;
+	CollectGarbage();
+	if (num_nodes * 2 > gc_threshold) gc_threshold *= 2; //mostly live, collecting again soon would not pay off
+}
+
+void ROBDDManager::CollectGarbage() //mark from the registered roots, then sweep the arena
+{
+	STAT_SCOPE(STAT_GC);
+	vector<bool> marked(top, false); //by arena index
+	marked[0] = true;
+	vector<ROBDDRef> stack;
+	for (ROBDD* robdd = handles; robdd != NULL; robdd = robdd->next_handle) stack.push_back(robdd->root);
+	while (!stack.empty())
+	{
+		ROBDDRef ref = stack.back();
+		stack.pop_back();
+		if (marked[ref >> 1]) continue;
+		marked[ref >> 1] = true;
+		stack.push_back(Node(ref).true_branch);
+		stack.push_back(Node(ref).false_branch);
+	}
+	ClearBuckets(buckets.size());
+	free_list = ROBDD_NULL;
+	alloc_epoch++;
+	for (ROBDDRef i = top - 1; i >= 1; i--)
+	{
+		ROBDDNode& node = Slot(i);
+		if (marked[i])
+		{
+			size_t bucket = BucketOf(node.label, node.true_branch, node.false_branch);
+			node.next = buckets[bucket].load(memory_order_relaxed);
+			buckets[bucket].store(i << 1, memory_order_relaxed);
+			continue;
+		}
+		if (node.label >= 0)
+		{
+			node.label = -2;
+			num_nodes--;
+			nodes_freed++;
+		}
+		node.next = free_list; //lowest slots are reused first
+		free_list = i;
+	}
+	for (size_t i = 0; i < cache.size(); i++) //drop results that mention freed nodes
+	{
+		ROBDDCacheEntry& entry = cache[i];
+		if (entry.op == -1) continue;
+		if (!marked[entry.f >> 1] || !marked[entry.g >> 1] || !marked[entry.h >> 1] || !marked[entry.result >> 1]) entry.op.store(-1, memory_order_relaxed);
+	}
+	gc_runs++;
+}
+
+void ROBDDManager::SetGCThreshold(size_t nodes)
+{
+	gc_threshold = nodes;
+}
+
+size_t ROBDDManager::GCThreshold()
+{
+	return gc_threshold;
+}
+
+size_t ROBDDManager::GCRuns()
+{
+	return gc_runs;
+}
+
+size_t ROBDDManager::PeakNodes()
+{
+	return peak_nodes;
+}
+
+void ROBDDManager::ResetPeakNodes()
+{
+	peak_nodes = num_nodes.load();
+}
+
+size_t ROBDDManager::NodesAllocated()
+{
+	return nodes_allocated;
+}
+
+size_t ROBDDManager::NodesFreed()
+{
+	return nodes_freed;
+}
+
+size_t ROBDDManager::ArenaBytes()
+{
+	return num_pages * (PAGE_MASK + 1) * sizeof(ROBDDNode) + buckets.size() * sizeof(ROBDDRef);
+}
+
+void ROBDDManager::AddVariables(int count)
+{
+	assert(concurrent == 0 || count <= var_to_level.size());
+	while (var_to_level.size() < count)
+	{
+		var_to_level.push_back(level_to_var.size());
+		level_to_var.push_back(var_to_level.size() - 1);
+	}
+}
+
+int ROBDDManager::VarAt(int level)
+{
+	return level_to_var[level];
+}
+
+int ROBDDManager::NumVars()
+{
+	return var_to_level.size();
+}
+
+void ROBDDManager::BeginReorder() //counts references from parents and from registered ROBDDs
+{
+	CollectGarbage();
+	refs.assign(top, 0);
+	var_nodes.assign(var_to_level.size(), vector<ROBDDRef>());
+	stamps.assign(top, 0);
+	stamp = 0;
+	for (ROBDDRef i = 1; i < top; i++)
+	{
+		ROBDDNode& node = Slot(i);
+		if (node.label < 0) continue;
+		Ref(node.true_branch);
+		Ref(node.false_branch);
+		var_nodes[node.label].push_back(i);
+	}
+	for (ROBDD* robdd = handles; robdd != NULL; robdd = robdd->next_handle) Ref(robdd->root);
+}
+
+void ROBDDManager::EndReorder()
+{
+	vector<int>().swap(refs);
+	vector<vector<ROBDDRef> >().swap(var_nodes);
+	vector<unsigned>().swap(stamps);
+	SetCacheSize(cache.size()); //entries may mention freed nodes
+}
+
+void ROBDDManager::Unlink(ROBDDRef index)
+{
+	ROBDDNode& node = Slot(index);
+	atomic<ROBDDRef>& head = buckets[BucketOf(node.label, node.true_branch, node.false_branch)];
+	if (head == index << 1)
+	{
+		head = node.next;
+		return;
+	}
+	ROBDDRef* link = &Node(head).next;
+	while (*link != index << 1) link = &Node(*link).next;
+	*link = node.next;
+}
+
+void ROBDDManager::Ref(ROBDDRef ref)
+{
+	if (ref >> 1 != 0) refs[ref >> 1]++;
+}
+
+void ROBDDManager::Deref(ROBDDRef ref)
+{
+	ROBDDRef index = ref >> 1;
+	if (index == 0 || --refs[index] != 0) return;
+	Unlink(index);
+	ROBDDNode& node = Slot(index);
+	Deref(node.true_branch);
+	Deref(node.false_branch);
+	node.label = -2;
+	node.next = free_list;
+	free_list = index;
+	num_nodes--;
+	nodes_freed++;
+}
+
+ROBDDRef ROBDDManager::ReorderNode(int label, ROBDDRef true_branch, ROBDDRef false_branch)
+{
+	size_t allocated = nodes_allocated;
+	ROBDDRef ret = MakeNode(label, true_branch, false_branch);
+	if (nodes_allocated != allocated) //a new node, it holds its children
+	{
+		if (refs.size() < top)
+		{
+			refs.resize(top, 0);
+			stamps.resize(top, 0);
+		}
+		refs[ret >> 1] = 0;
+		Ref(Node(ret).true_branch);
+		Ref(Node(ret).false_branch);
+		var_nodes[label].push_back(ret >> 1);
+	}
+	Ref(ret);
+	return ret;
+}
+
+vector<ROBDDRef>& ROBDDManager::LiveNodes(int var) //drops stale and duplicate entries
+{
+	vector<ROBDDRef>& nodes = var_nodes[var];
+	stamp++;
+	size_t kept = 0;
+	for (size_t i = 0; i < nodes.size(); i++)
+	{
+		if (Slot(nodes[i]).label != var || stamps[nodes[i]] == stamp) continue;
+		stamps[nodes[i]] = stamp;
+		nodes[kept++] = nodes[i];
+	}
+	nodes.resize(kept);
+	return nodes;
+}
+
+static ROBDDRef Cofactor(ROBDDManager& manager, ROBDDRef ref, int label, bool branch)
+{
+	ROBDDNode& node = manager.Node(ref);
+	if (node.label != label) return ref;
+	return (branch ? node.true_branch : node.false_branch) ^ (ref & 1);
+}
+
+void ROBDDManager::SwapLevels(int level)
+{
+	int x = level_to_var[level], y = level_to_var[level + 1];
+	vector<ROBDDRef> xs = LiveNodes(x);
+	LiveNodes(y);
+	vector<ROBDDRef> moved;
+	var_nodes[x].clear();
+	for (size_t i = 0; i < xs.size(); i++)
+	{
+		ROBDDNode& node = Slot(xs[i]);
+		if (Node(node.true_branch).label == y || Node(node.false_branch).label == y) moved.push_back(xs[i]);
+		else var_nodes[x].push_back(xs[i]); //does not test y, so it simply sinks below it
+	}
+	for (size_t i = 0; i < moved.size(); i++) //x ? (y ? a : b) : (y ? c : d) becomes y ? (x ? a : c) : (x ? b : d), same node
+	{
+		ROBDDRef T = Slot(moved[i]).true_branch, E = Slot(moved[i]).false_branch;
+		ROBDDRef TrueNode = ReorderNode(x, Cofactor(*this, T, y, true), Cofactor(*this, E, y, true)); //regular, T is
+		ROBDDRef FalseNode = ReorderNode(x, Cofactor(*this, T, y, false), Cofactor(*this, E, y, false));
+		Unlink(moved[i]);
+		ROBDDNode& node = Slot(moved[i]);
+		node.label = y;
+		node.true_branch = TrueNode;
+		node.false_branch = FalseNode;
+		size_t bucket = BucketOf(y, TrueNode, FalseNode);
+		node.next = buckets[bucket].load(memory_order_relaxed);
+		buckets[bucket].store(moved[i] << 1, memory_order_relaxed);
+		var_nodes[y].push_back(moved[i]);
+		Deref(T);
+		Deref(E);
+	}
+	swap(level_to_var[level], level_to_var[level + 1]);
+	var_to_level[x] = level + 1;
+	var_to_level[y] = level;
+}
+
+void ROBDDManager::Sift(int var) //moves var through every level and leaves it where the fewest nodes are live
+{
+	int levels = level_to_var.size();
+	int level = var_to_level[var], best_level = level;
+	size_t best = num_nodes;
+	while (level < levels - 1)
+	{
+		SwapLevels(level++);
+		if (num_nodes < best)
+		{
+			best = num_nodes;
+			best_level = level;
+		}
+		else if (num_nodes > best * 6 / 5) break; //growing too much, give up on this direction
+	}
+	while (level > 0)
+	{
+		SwapLevels(--level);
+		if (num_nodes < best)
+		{
+			best = num_nodes;
+			best_level = level;
+		}
+		else if (level < best_level && num_nodes > best * 6 / 5) break;
+	}
+	while (level < best_level) SwapLevels(level++);
+	while (level > best_level) SwapLevels(--level);
+}
+
+void ROBDDManager::Reorder()
+{
+	STAT_SCOPE(STAT_REORDER);
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	BeginReorder();
+	reorder_before = num_nodes;
+	vector<pair<size_t, int> > vars; //largest levels are sifted first
+	for (int i = 0; i < var_nodes.size(); i++)
+	{
+		if (!var_nodes[i].empty()) vars.push_back(make_pair(var_nodes[i].size(), i));
+	}
+	sort(vars.rbegin(), vars.rend());
+	for (int i = 0; i < vars.size(); i++) Sift(vars[i].second);
+	EndReorder();
+	reorder_after = num_nodes;
+	reorder_threshold = max((size_t)MIN_REORDER_NODES, (size_t)num_nodes * 2);
+	reorder_runs++;
+	reorder_seconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+void ROBDDManager::SetOrder(const vector<int>& order)
+{
+	for (int i = 0; i < order.size(); i++) Level(order[i]);
+	BeginReorder();
+	for (int i = 0; i < order.size(); i++)
+	{
+		for (int level = var_to_level[order[i]]; level > i; level--) SwapLevels(level - 1);
+	}
+	EndReorder();
+}
+
+void ROBDDManager::SetAutoReorder(bool enabled)
+{
+	auto_reorder = enabled;
+}
+
+size_t ROBDDManager::ReorderRuns()
+{
+	return reorder_runs;
+}
+
+double ROBDDManager::ReorderSeconds()
+{
+	return reorder_seconds;
+}
+
+size_t ROBDDManager::NodesBeforeReorder()
+{
+	return reorder_before;
+}
+
+size_t ROBDDManager::NodesAfterReorder()
+{
+	return reorder_after;
+}
+
+void ROBDDManager::BeginConcurrent()
+{
+	concurrent++;
+}
+
+void ROBDDManager::EndConcurrent()
+{
+	if (--concurrent > 0) return;
+	while (num_nodes > buckets.size()) ResizeTable();
+}
+
+ROBDDManager& Manager()
+{
+	static ROBDDManager* manager = new ROBDDManager; //never destroyed, ROBDDs may outlive static destruction
+	return *manager;
+}
+
+size_t PeakRSS()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+	return counters.PeakWorkingSetSize;
+#else
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef __APPLE__
+	return usage.ru_maxrss;
+#else
+	return (size_t)usage.ru_maxrss * 1024;
+#endif
+#endif
+}
@@ -0,0 +1,137 @@
+#pragma once
+#include<vector>
+#include<cstddef>
+#include<climits>
+#include<atomic>
+#include<mutex>
+using namespace std;
+typedef unsigned int ROBDDRef; //edge to a node: arena index shifted left by one, low bit set if the edge is complemented
+const ROBDDRef ROBDD_TRUE = 0; //the only leaf
+const ROBDDRef ROBDD_FALSE = 1;
+const ROBDDRef ROBDD_NULL = 0xFFFFFFFF;
+inline ROBDDRef Regular(ROBDDRef ref) { return ref & ~1u; }
+inline bool IsComplement(ROBDDRef ref) { return (ref & 1) != 0; }
+inline ROBDDRef Complement(ROBDDRef ref) { return ref ^ 1; }
+struct ROBDDNode //16 bytes, four to a cache line
+{
+	int label; //-1 for leaf, -2 for a free slot
+	ROBDDRef true_branch; //never complemented, so every function has one representation
+	ROBDDRef false_branch;
+	ROBDDRef next; //next node in the same unique table bucket, or in the free list
+};
+enum ROBDDOp
+{
+	OP_AND,
+	OP_ITE,
+	OP_EXISTS,
+	OP_AND_EXISTS,
+	OP_RESTRICT
+};
+struct ROBDDCacheEntry //a seqlock, so threads can share the cache without locking
+{
+	atomic<unsigned> version; //odd while a writer fills the entry
+	atomic<int> op; //-1 for an empty slot
+	atomic<ROBDDRef> f;
+	atomic<ROBDDRef> g;
+	atomic<ROBDDRef> h; //ROBDD_TRUE for two-operand ops
+	atomic<ROBDDRef> result;
+};
+class ROBDD;
+class ROBDDManager //owns every node, so that equal functions are represented by the same node
+{
+public:
+	ROBDDManager();
+	ROBDDNode& Node(ROBDDRef ref) { return Slot(ref >> 1); } //ignores the complement bit
+	ROBDDRef Leaf(int value);
+	ROBDDRef MakeNode(int label, ROBDDRef true_branch, ROBDDRef false_branch); //reduced and hash-consed
+	size_t NumNodes(); //live nodes, leaves included
+	bool CacheLookup(int op, ROBDDRef f, ROBDDRef g, ROBDDRef& result);
+	bool CacheLookup(int op, ROBDDRef f, ROBDDRef g, ROBDDRef h, ROBDDRef& result);
+	void CacheInsert(int op, ROBDDRef f, ROBDDRef g, ROBDDRef result); //overwrites whatever shares the slot
+	void CacheInsert(int op, ROBDDRef f, ROBDDRef g, ROBDDRef h, ROBDDRef result);
+	void SetCacheSize(size_t entries); //rounded up to a power of two, clears the cache
+	size_t CacheSize();
+	size_t CacheHits();
+	size_t CacheMisses();
+	size_t CacheOccupancy(); //entries in use, by a scan of the cache
+	size_t TableSize(); //buckets of the unique table
+	size_t TableOccupancy(); //buckets holding a node, by a scan of the table
+	vector<size_t> NodesPerLevel(); //nodes in the arena at each level, garbage not collected yet included
+	void Register(ROBDD* robdd); //roots of registered ROBDDs survive garbage collection
+	void Unregister(ROBDD* robdd);
+	void MaybeCollect(); //only call where every node in use is held by an ROBDD, does nothing in a concurrent section
+	void CollectGarbage();
+	void SetGCThreshold(size_t nodes); //collect once this many nodes are live
+	size_t GCThreshold();
+	size_t GCRuns();
+	size_t PeakNodes();
+	void ResetPeakNodes(); //the peak starts again from the live node count
+	size_t NodesAllocated();
+	size_t NodesFreed();
+	size_t ArenaBytes(); //memory held by arena pages and the unique table
+	int Level(int label) //position of the variable in the order, leaves sit below every variable
+	{
+		if (label < 0) return INT_MAX;
+		if (label >= var_to_level.size()) AddVariables(label + 1);
+		return var_to_level[label];
+	}
+	void AddVariables(int count); //x_0..x_(count-1) exist from here on. Readers take no lock and the tables may move, so never while concurrent: create the variables of a parallel computation before it starts
+	int VarAt(int level);
+	int NumVars();
+	void SetOrder(const vector<int>& order); //order lists variables from the top, the rest keep their relative order below
+	void Reorder(); //Rudell's sifting, only call where every node in use is held by an ROBDD
+	void SetAutoReorder(bool enabled); //off by default. Sift whenever the live node count has doubled since the last reordering, and is at least MIN_REORDER_NODES
+	size_t ReorderRuns();
+	double ReorderSeconds(); //total time spent reordering
+	size_t NodesBeforeReorder(); //live nodes before and after the last reordering
+	size_t NodesAfterReorder();
+	void BeginConcurrent(); //from here until the matching EndConcurrent, several threads may build nodes and ROBDDs
+	void EndConcurrent();
+private:
+	static const int PAGE_BITS = 16;
+	static const ROBDDRef PAGE_MASK = (1 << PAGE_BITS) - 1;
+	static const int MAX_PAGES = 1 << (31 - PAGE_BITS);
+	static const int ALLOC_BATCH = 256; //free slots a thread takes at once while concurrent
+	static const size_t MIN_REORDER_NODES = 1 << 16; //smaller BDDs are cheaper to use than to sift
+	vector<ROBDDNode*> pages; //fixed size, so readers never see it move
+	size_t num_pages;
+	ROBDDRef top; //arena indices below top have been handed out at least once
+	ROBDDRef free_list; //arena index of the first free slot
+	atomic<size_t> num_nodes, peak_nodes, nodes_allocated, nodes_freed;
+	vector<atomic<ROBDDRef> > buckets; //unique table of regular edges, chained through ROBDDNode::next
+	vector<ROBDDCacheEntry> cache;
+	atomic<size_t> cache_hits, cache_misses;
+	atomic<int> concurrent; //nesting count of concurrent sections
+	mutex handle_mutex;
+	atomic<size_t> alloc_epoch; //bumped whenever free slots are redistributed, invalidating the slots threads hold
+	mutex alloc_mutex;
+	ROBDD* handles; //every live ROBDD, linked through ROBDD::prev_handle/next_handle
+	size_t gc_threshold, gc_runs;
+	vector<int> var_to_level, level_to_var;
+	bool auto_reorder;
+	size_t reorder_threshold, reorder_runs, reorder_before, reorder_after;
+	double reorder_seconds;
+	vector<int> refs; //by arena index, only kept while reordering
+	vector<vector<ROBDDRef> > var_nodes; //arena indices of the nodes of each variable, may hold stale entries
+	vector<unsigned> stamps;
+	unsigned stamp;
+	ROBDDNode& Slot(ROBDDRef index) { return pages[index >> PAGE_BITS][index & PAGE_MASK]; }
+	ROBDDRef AllocNode(); //returns an arena index
+	void ReleaseNode(ROBDDRef index); //gives back a node that was never published
+	void NewPage();
+	void ClearBuckets(size_t size);
+	size_t BucketOf(int label, ROBDDRef true_branch, ROBDDRef false_branch);
+	void ResizeTable();
+	size_t CacheSlot(int op, ROBDDRef f, ROBDDRef g, ROBDDRef h);
+	void BeginReorder();
+	void EndReorder();
+	void Unlink(ROBDDRef index); //removes the node from its unique table bucket
+	void Ref(ROBDDRef ref);
+	void Deref(ROBDDRef ref); //frees the node once nothing points to it
+	ROBDDRef ReorderNode(int label, ROBDDRef true_branch, ROBDDRef false_branch); //MakeNode that keeps reference counts
+	vector<ROBDDRef>& LiveNodes(int var);
+	void SwapLevels(int level); //exchanges the variables at level and level + 1 in place
+	void Sift(int var);
+};
+ROBDDManager& Manager(); //the manager shared by all ROBDDs
+size_t PeakRSS(); //peak resident set size of the process in bytes, 0 if unknown
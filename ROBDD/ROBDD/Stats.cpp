@@ -0,0 +1,164 @@
+#include "Stats.h"
+#include "ROBDDManager.h"
+#include <atomic>
+#include <mutex>
+#include <deque>
+
+static const char* const OpNames[NUM_STAT_OPS] = { "AND", "OR", "IMPLY", "ITE", "EXISTS", "AND_EXISTS", "RESTRICT", "COMPOSE", "RENAME",
+	"BUILD", "SIMPLIFY", "PREIMAGE", "IMAGE", "EX", "EG", "EU", "GC", "REORDER" };
+static const char* const KernelNames[] = { "AND", "ITE", "EXISTS", "AND_EXISTS" }; //by ROBDDOp, Restrict keeps no depth
+static const int NUM_KERNELS = sizeof(KernelNames) / sizeof(KernelNames[0]);
+
+#ifdef ROBDD_STATS
+static atomic<size_t> op_calls[NUM_STAT_OPS], op_nodes[NUM_STAT_OPS];
+static atomic<long long> op_nanoseconds[NUM_STAT_OPS];
+static atomic<size_t> kernel_steps[NUM_KERNELS];
+static atomic<int> kernel_depth[NUM_KERNELS];
+static mutex fixpoint_mutex;
+static deque<FixpointStats> fixpoints;
+static long long first_fixpoint = 0; //id of fixpoints.front()
+
+StatScope::StatScope(int op)
+{
+	this->op = op;
+	allocated = Manager().NodesAllocated();
+	start = chrono::steady_clock::now();
+}
+
+StatScope::~StatScope()
+{
+	long long elapsed = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+	op_calls[op].fetch_add(1, memory_order_relaxed);
+	op_nanoseconds[op].fetch_add(elapsed, memory_order_relaxed);
+	op_nodes[op].fetch_add(Manager().NodesAllocated() - allocated, memory_order_relaxed);
+}
+
+void CountStep(int op, int depth)
+{
+	kernel_steps[op].fetch_add(1, memory_order_relaxed);
+	int deepest = kernel_depth[op].load(memory_order_relaxed);
+	while (depth > deepest && !kernel_depth[op].compare_exchange_weak(deepest, depth, memory_order_relaxed));
+}
+
+long long BeginFixpoint(int op)
+{
+	lock_guard<mutex> lock(fixpoint_mutex);
+	FixpointStats fixpoint;
+	fixpoint.op = op;
+	fixpoints.push_back(fixpoint);
+	if (fixpoints.size() > MAX_FIXPOINTS)
+	{
+		fixpoints.pop_front();
+		first_fixpoint++;
+	}
+	return first_fixpoint + fixpoints.size() - 1;
+}
+
+void RecordFrontier(long long fixpoint, size_t nodes)
+{
+	lock_guard<mutex> lock(fixpoint_mutex);
+	if (fixpoint >= first_fixpoint) fixpoints[fixpoint - first_fixpoint].frontier.push_back(nodes); //dropped ones are ignored
+}
+#endif
+
+bool StatsEnabled()
+{
+#ifdef ROBDD_STATS
+	return true;
+#else
+	return false;
+#endif
+}
+
+const char* StatOpName(int op)
+{
+	return OpNames[op];
+}
+
+OpStats GetOpStats(int op)
+{
+	OpStats ret = { 0, 0, 0 };
+#ifdef ROBDD_STATS
+	ret.calls = op_calls[op];
+	ret.seconds = op_nanoseconds[op] / 1e9;
+	ret.nodes = op_nodes[op];
+#else
+	(void)op;
+#endif
+	return ret;
+}
+
+KernelStats GetKernelStats(int op)
+{
+	KernelStats ret = { 0, 0 };
+#ifdef ROBDD_STATS
+	ret.steps = kernel_steps[op];
+	ret.max_depth = kernel_depth[op];
+#else
+	(void)op;
+#endif
+	return ret;
+}
+
+vector<FixpointStats> RecentFixpoints()
+{
+#ifdef ROBDD_STATS
+	lock_guard<mutex> lock(fixpoint_mutex);
+	return vector<FixpointStats>(fixpoints.begin(), fixpoints.end());
+#else
+	return vector<FixpointStats>();
+#endif
+}
+
+void ResetStats()
+{
+#ifdef ROBDD_STATS
+	for (int i = 0; i < NUM_STAT_OPS; i++)
+	{
+		op_calls[i] = 0;
+		op_nanoseconds[i] = 0;
+		op_nodes[i] = 0;
+	}
+	for (int i = 0; i < NUM_KERNELS; i++)
+	{
+		kernel_steps[i] = 0;
+		kernel_depth[i] = 0;
+	}
+	lock_guard<mutex> lock(fixpoint_mutex);
+	first_fixpoint += fixpoints.size();
+	fixpoints.clear();
+#endif
+}
+
+void DumpStats(ostream& out)
+{
+	out << "{\"enabled\": " << (StatsEnabled() ? "true" : "false") << ",\n\"ops\": {";
+	for (int i = 0; i < NUM_STAT_OPS; i++)
+	{
+		OpStats op = GetOpStats(i);
+		out << (i == 0 ? "" : ", ") << "\"" << OpNames[i] << "\": {\"calls\": " << op.calls << ", \"ms\": " << op.seconds * 1000 << ", \"nodes\": " << op.nodes << "}";
+	}
+	out << "},\n\"kernels\": {";
+	for (int i = 0; i < NUM_KERNELS; i++)
+	{
+		KernelStats kernel = GetKernelStats(i);
+		out << (i == 0 ? "" : ", ") << "\"" << KernelNames[i] << "\": {\"steps\": " << kernel.steps << ", \"max_depth\": " << kernel.max_depth << "}";
+	}
+	ROBDDManager& manager = Manager();
+	out << "},\n\"manager\": {\"live_nodes\": " << manager.NumNodes() << ", \"peak_nodes\": " << manager.PeakNodes();
+	out << ", \"table_buckets\": " << manager.TableSize() << ", \"table_occupied\": " << manager.TableOccupancy();
+	out << ", \"cache_entries\": " << manager.CacheSize() << ", \"cache_occupied\": " << manager.CacheOccupancy();
+	out << ", \"cache_hits\": " << manager.CacheHits() << ", \"cache_misses\": " << manager.CacheMisses();
+	out << ", \"gc_runs\": " << manager.GCRuns() << ", \"reorder_runs\": " << manager.ReorderRuns() << "},\n\"nodes_per_level\": [";
+	vector<size_t> levels = manager.NodesPerLevel();
+	for (int i = 0; i < levels.size(); i++) out << (i == 0 ? "" : ", ") << levels[i];
+	out << "],\n\"fixpoints\": [";
+	vector<FixpointStats> recent = RecentFixpoints();
+	for (int i = 0; i < recent.size(); i++)
+	{
+		out << (i == 0 ? "" : ",") << "\n{\"op\": \"" << OpNames[recent[i].op] << "\", \"frontier\": [";
+		for (int j = 0; j < recent[i].frontier.size(); j++) out << (j == 0 ? "" : ", ") << recent[i].frontier[j];
+		out << "]}";
+	}
+	out << "]}\n";
+}
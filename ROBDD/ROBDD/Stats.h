@@ -0,0 +1,78 @@
+#pragma once
+#include<vector>
+#include<ostream>
+#include<chrono>
+#include<cstddef>
+using namespace std;
+//Counters of the operations, kernels and fixpoints. They are only collected in builds that define ROBDD_STATS,
+//otherwise the STAT_ macros expand to nothing and every query returns zeros.
+enum StatOp
+{
+	STAT_AND,
+	STAT_OR,
+	STAT_IMPLY,
+	STAT_ITE,
+	STAT_EXISTS, //FORALL included
+	STAT_AND_EXISTS,
+	STAT_RESTRICT,
+	STAT_COMPOSE,
+	STAT_RENAME,
+	STAT_BUILD, //FromTrueValueVector, FromRange and ConvertFromGraph
+	STAT_SIMPLIFY,
+	STAT_PREIMAGE,
+	STAT_IMAGE,
+	STAT_EX,
+	STAT_EG,
+	STAT_EU,
+	STAT_GC,
+	STAT_REORDER,
+	NUM_STAT_OPS
+};
+struct OpStats
+{
+	size_t calls;
+	double seconds; //includes the operations it calls
+	size_t nodes; //nodes allocated meanwhile, by any thread
+};
+struct KernelStats //recursive kernels, by ROBDDOp
+{
+	size_t steps; //calls that got past the terminal cases
+	int max_depth; //deepest recursion seen
+};
+struct FixpointStats
+{
+	int op; //STAT_EG or STAT_EU
+	vector<size_t> frontier; //nodes of the frontier at each epoch
+};
+const int MAX_FIXPOINTS = 256; //only the latest fixpoints are kept
+bool StatsEnabled(); //whether this build collects anything
+const char* StatOpName(int op);
+OpStats GetOpStats(int op);
+KernelStats GetKernelStats(int op);
+vector<FixpointStats> RecentFixpoints(); //oldest first
+void ResetStats();
+void DumpStats(ostream& out); //JSON, the manager's table, cache and nodes per level included
+#ifdef ROBDD_STATS
+class StatScope //counts one call of an operation
+{
+public:
+	StatScope(int op);
+	~StatScope();
+private:
+	int op;
+	chrono::steady_clock::time_point start;
+	size_t allocated;
+};
+void CountStep(int op, int depth);
+long long BeginFixpoint(int op); //an id for RecordFrontier
+void RecordFrontier(long long fixpoint, size_t nodes);
+#define STAT_SCOPE(op) StatScope stat_scope(op)
+#define STAT_STEP(op, depth) CountStep(op, depth)
+#define STAT_FIXPOINT(op) long long stat_fixpoint = BeginFixpoint(op)
+#define STAT_FRONTIER(robdd) RecordFrontier(stat_fixpoint, (robdd).NodeCount())
+#else
+#define STAT_SCOPE(op)
+#define STAT_STEP(op, depth)
+#define STAT_FIXPOINT(op)
+#define STAT_FRONTIER(robdd)
+#endif
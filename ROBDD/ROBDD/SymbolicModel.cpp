@@ -0,0 +1,644 @@
+#include "SymbolicModel.h"
+#include "MathFunc.h"
+#include <cctype>
+#include <cstring>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+static const int ENUM_BASE = 1 << 24; //codes of enumeration names, far from the numbers of a model
+static const char* const SECTIONS[] = { "MODULE", "VAR", "DEFINE", "ASSIGN", "INIT", "INVAR", "TRANS", "FAIRNESS", "SPEC", "CTLSPEC" };
+static const char* const SYMBOLS[] = { ":=", "..", "<->", "->", "!=", "<=", ">=" }; //longest first, the rest are single characters
+
+SymbolicModel::SymbolicModel()
+{
+	text = NULL;
+	pos = 0;
+	depth = 0;
+	next_allowed = false;
+}
+
+bool SymbolicModel::Load(const string& path)
+{
+	ifstream file(path.c_str());
+	if (!file)
+	{
+		error = "cannot open " + path;
+		return false;
+	}
+	stringstream contents;
+	contents << file.rdbuf();
+	return Parse(contents.str());
+}
+
+string SymbolicModel::Error()
+{
+	return error;
+}
+
+void SymbolicModel::Next()
+{
+	const string& s = *text;
+	while (pos < s.length())
+	{
+		if (isspace((unsigned char)s[pos])) pos++;
+		else if (s.compare(pos, 2, "--") == 0) //a comment
+		{
+			while (pos < s.length() && s[pos] != '\n') pos++;
+		}
+		else break;
+	}
+	token.start = pos;
+	if (pos == s.length())
+	{
+		token.type = MODEL_END;
+		token.length = 0;
+		return;
+	}
+	char c = s[pos];
+	if (isalpha((unsigned char)c) || c == '_')
+	{
+		while (pos < s.length() && (isalnum((unsigned char)s[pos]) || s[pos] == '_')) pos++;
+		token.type = MODEL_NAME;
+	}
+	else if (isdigit((unsigned char)c))
+	{
+		while (pos < s.length() && isdigit((unsigned char)s[pos])) pos++;
+		token.type = MODEL_NUMBER;
+	}
+	else
+	{
+		token.type = MODEL_SYMBOL;
+		int length = 1;
+		for (int i = 0; i < 7; i++)
+		{
+			if (s.compare(pos, strlen(SYMBOLS[i]), SYMBOLS[i]) == 0)
+			{
+				length = strlen(SYMBOLS[i]);
+				break;
+			}
+		}
+		if (length == 1 && string("(){},;:=<>+-*/!&|").find(c) == string::npos) token.type = MODEL_ERROR;
+		pos += length;
+	}
+	token.length = pos - token.start;
+}
+
+bool SymbolicModel::Is(const char* word)
+{
+	return (token.type == MODEL_NAME || token.type == MODEL_SYMBOL) && text->compare(token.start, token.length, word) == 0;
+}
+
+bool SymbolicModel::Section()
+{
+	for (int i = 0; i < 10; i++)
+	{
+		if (Is(SECTIONS[i])) return true;
+	}
+	return false;
+}
+
+bool SymbolicModel::Fail(const string& message)
+{
+	if (error.empty())
+	{
+		int line = count(text->begin(), text->begin() + token.start, '\n') + 1;
+		error = message + " at line " + to_string(line);
+	}
+	return false;
+}
+
+bool SymbolicModel::Expect(const char* word)
+{
+	if (!Is(word)) return Fail(string("expected '") + word + "'");
+	Next();
+	return true;
+}
+
+void SymbolicModel::Skip()
+{
+	do Next(); while (token.type != MODEL_END && !Section());
+}
+
+bool SymbolicModel::Parse(const string& text)
+{
+	this->text = &text;
+	error.clear();
+	variables.clear();
+	variable_index.clear();
+	constants.clear();
+	constant_names.clear();
+	defines.clear();
+	invariants.clear();
+	transitions.clear();
+	names.clear();
+	propositions.clear();
+	fairness.clear();
+	specs.clear();
+	pos = 0;
+	Next();
+	while (token.type != MODEL_END) //declarations first, so that the state bits are known before anything is compiled
+	{
+		if (!Is("VAR"))
+		{
+			Skip();
+			continue;
+		}
+		Next();
+		while (token.type != MODEL_END && !Section())
+		{
+			if (!Declare()) return false;
+		}
+	}
+	if (variables.empty()) return Fail("no variables");
+	Encode();
+	pos = 0;
+	Next();
+	while (token.type != MODEL_END)
+	{
+		if (Is("MODULE"))
+		{
+			Next();
+			if (!Expect("main")) return false;
+		}
+		else if (Is("VAR")) Skip();
+		else if (Is("DEFINE") || Is("ASSIGN"))
+		{
+			bool define = Is("DEFINE");
+			Next();
+			while (token.type != MODEL_END && !Section())
+			{
+				if (!(define ? Define() : Assign())) return false;
+			}
+		}
+		else if (Is("INIT") || Is("INVAR") || Is("TRANS") || Is("FAIRNESS"))
+		{
+			string section(*this->text, token.start, token.length);
+			next_allowed = section == "TRANS";
+			Next();
+			ROBDD truth = Truth(Implication());
+			next_allowed = false;
+			if (!error.empty()) return false;
+			if (Is(";")) Next();
+			if (!Section() && token.type != MODEL_END) return Fail("unexpected input");
+			if (section == "INIT") init = AND(init, truth);
+			else if (section == "INVAR") invariants.push_back(truth);
+			else if (section == "TRANS") transitions.push_back(truth);
+			else fairness.push_back(truth);
+		}
+		else if (Is("SPEC") || Is("CTLSPEC"))
+		{
+			int start = pos;
+			Skip();
+			string spec(*this->text, start, token.start - start);
+			size_t first = spec.find_first_not_of(" \t\r\n"), last = spec.find_last_not_of(" \t\r\n;");
+			if (first == string::npos || last < first) return Fail("empty specification");
+			specs.push_back(spec.substr(first, last + 1 - first));
+		}
+		else return Fail("expected a section");
+	}
+	Build();
+	return true;
+}
+
+bool SymbolicModel::Declare()
+{
+	if (token.type != MODEL_NAME) return Fail("expected a variable");
+	ModelVariable variable;
+	variable.name.assign(*text, token.start, token.length);
+	variable.assigned = false;
+	variable.boolean = false;
+	if (variable_index.count(variable.name)) return Fail(variable.name + " declared twice");
+	Next();
+	if (!Expect(":")) return false;
+	if (Is("boolean"))
+	{
+		variable.boolean = true;
+		variable.values.push_back(0);
+		variable.values.push_back(1);
+		Next();
+	}
+	else if (Is("{"))
+	{
+		do
+		{
+			Next();
+			if (token.type == MODEL_NUMBER) variable.values.push_back(atoi(text->c_str() + token.start));
+			else if (token.type == MODEL_NAME)
+			{
+				string constant(*text, token.start, token.length);
+				if (!constants.count(constant))
+				{
+					int code = ENUM_BASE + constants.size();
+					constants[constant] = code;
+					constant_names[code] = constant;
+				}
+				variable.values.push_back(constants[constant]);
+			}
+			else return Fail("expected a value");
+			Next();
+		} while (Is(","));
+		if (!Expect("}")) return false;
+	}
+	else
+	{
+		int bounds[2];
+		for (int i = 0; i < 2; i++)
+		{
+			bool negative = Is("-");
+			if (negative) Next();
+			if (token.type != MODEL_NUMBER) return Fail("expected a type");
+			bounds[i] = atoi(text->c_str() + token.start) * (negative ? -1 : 1);
+			Next();
+			if (i == 0 && !Expect("..")) return false;
+		}
+		if (bounds[0] > bounds[1]) return Fail("empty range");
+		for (int value = bounds[0]; value <= bounds[1]; value++) variable.values.push_back(value);
+	}
+	if (!Expect(";")) return false;
+	variable_index[variable.name] = variables.size();
+	variables.push_back(variable);
+	return true;
+}
+
+void SymbolicModel::Encode() //each variable gets the next bits, x_i next to its next-state copy x_(depth+i) in the order
+{
+	depth = 0;
+	for (int i = 0; i < variables.size(); i++)
+	{
+		variables[i].first = depth;
+		variables[i].bits = BitsFor(variables[i].values.size());
+		depth += variables[i].bits;
+	}
+	vector<int> order;
+	for (int i = 0; i < depth; i++)
+	{
+		order.push_back(i);
+		order.push_back(depth + i);
+	}
+	Manager().SetOrder(order);
+	for (int i = 0; i < variables.size(); i++)
+	{
+		ModelVariable& variable = variables[i];
+		variable.current.resize(variable.values.size());
+		variable.next.resize(variable.values.size());
+		for (int j = 0; j < variable.values.size(); j++)
+		{
+			vector<signed char> cube(2 * depth, -1);
+			for (int k = 0; k < variable.bits; k++) cube[variable.first + k] = j >> (variable.bits - 1 - k) & 1;
+			variable.current[j].FromCubes(vector<vector<signed char> >(1, cube));
+			for (int k = 0; k < variable.bits; k++) swap(cube[variable.first + k], cube[depth + variable.first + k]);
+			variable.next[j].FromCubes(vector<vector<signed char> >(1, cube));
+		}
+	}
+	init.FromConstant(1);
+}
+
+bool SymbolicModel::Define()
+{
+	if (token.type != MODEL_NAME) return Fail("expected a name");
+	string name(*text, token.start, token.length);
+	if (variable_index.count(name) || defines.count(name) || constants.count(name)) return Fail(name + " declared twice");
+	Next();
+	if (!Expect(":=")) return false;
+	ModelValues values = Implication();
+	if (!error.empty() || !Expect(";")) return false;
+	defines[name] = values;
+	names.push_back(name);
+	propositions.push_back(Truth(values));
+	return true;
+}
+
+bool SymbolicModel::Assign() //init(x) := e, next(x) := e, or x := e for every state
+{
+	int kind = Is("init") ? 1 : Is("next") ? 2 : 0;
+	if (kind != 0)
+	{
+		Next();
+		if (!Expect("(")) return false;
+	}
+	if (token.type != MODEL_NAME || !variable_index.count(string(*text, token.start, token.length))) return Fail("expected a variable");
+	ModelVariable& variable = variables[variable_index[string(*text, token.start, token.length)]];
+	Next();
+	if (kind != 0 && !Expect(")")) return false;
+	if (!Expect(":=")) return false;
+	next_allowed = kind == 2;
+	ModelValues values = Implication();
+	next_allowed = false;
+	if (!error.empty() || !Expect(";")) return false;
+	if (kind == 1) init = AND(init, Equals(variable, values, false));
+	else if (kind == 0) invariants.push_back(Equals(variable, values, false));
+	else
+	{
+		if (variable.assigned) return Fail("next(" + variable.name + ") assigned twice");
+		variable.assigned = true;
+		transitions.push_back(Equals(variable, values, true));
+	}
+	return true;
+}
+
+ROBDD SymbolicModel::Equals(ModelVariable& variable, const ModelValues& values, bool next)
+{
+	ROBDD ret;
+	for (ModelValues::const_iterator it = values.begin(); it != values.end(); ++it)
+	{
+		int index = find(variable.values.begin(), variable.values.end(), it->first) - variable.values.begin();
+		if (index < variable.values.size()) ret = OR(ret, AND(it->second, next ? variable.next[index] : variable.current[index]));
+	}
+	return ret;
+}
+
+ROBDD SymbolicModel::Truth(const ModelValues& values)
+{
+	ROBDD ret;
+	for (ModelValues::const_iterator it = values.begin(); it != values.end(); ++it)
+	{
+		if (it->first != 0) ret = OR(ret, it->second);
+	}
+	return ret;
+}
+
+static ModelValues Constant(int value)
+{
+	ModelValues ret;
+	ret[value].FromConstant(1);
+	return ret;
+}
+
+static ModelValues Boolean(ROBDD truth)
+{
+	ModelValues ret;
+	if (truth.root != ROBDD_FALSE) ret[1] = truth;
+	if (truth.root != ROBDD_TRUE) ret[0] = NOT(truth);
+	return ret;
+}
+
+static bool Apply(const string& op, int a, int b, int& result) //false where op has no value
+{
+	if (op == "+") result = a + b;
+	else if (op == "-") result = a - b;
+	else if (op == "*") result = a * b;
+	else if (op == "/" || op == "mod")
+	{
+		if (b == 0) return false;
+		result = op == "/" ? a / b : a % b;
+	}
+	else if (op == "=") result = a == b;
+	else if (op == "!=") result = a != b;
+	else if (op == "<") result = a < b;
+	else if (op == "<=") result = a <= b;
+	else if (op == ">") result = a > b;
+	else result = a >= b;
+	return true;
+}
+
+static ModelValues Combine(const string& op, const ModelValues& left, const ModelValues& right) //every pair of values, where both hold
+{
+	ModelValues ret;
+	for (ModelValues::const_iterator a = left.begin(); a != left.end(); ++a)
+	{
+		for (ModelValues::const_iterator b = right.begin(); b != right.end(); ++b)
+		{
+			int result;
+			if (!Apply(op, a->first, b->first, result)) continue;
+			ROBDD both = AND(a->second, b->second);
+			if (both.root != ROBDD_FALSE) ret[result] = OR(ret[result], both);
+		}
+	}
+	return ret;
+}
+
+ModelValues SymbolicModel::Implication() //right associative, binds weakest
+{
+	ModelValues left = Equivalence();
+	if (!error.empty() || !Is("->")) return left;
+	Next();
+	ModelValues right = Implication();
+	return Boolean(IMPLY(Truth(left), Truth(right)));
+}
+
+ModelValues SymbolicModel::Equivalence()
+{
+	ModelValues left = Disjunction();
+	while (error.empty() && Is("<->"))
+	{
+		Next();
+		ROBDD right = Truth(Disjunction());
+		left = Boolean(NOT(ITE(Truth(left), NOT(right), right)));
+	}
+	return left;
+}
+
+ModelValues SymbolicModel::Disjunction()
+{
+	ModelValues left = Conjunction();
+	while (error.empty() && (Is("|") || Is("xor")))
+	{
+		bool exclusive = Is("xor");
+		Next();
+		ROBDD right = Truth(Conjunction());
+		left = Boolean(exclusive ? ITE(Truth(left), NOT(right), right) : OR(Truth(left), right));
+	}
+	return left;
+}
+
+ModelValues SymbolicModel::Conjunction()
+{
+	ModelValues left = Comparison();
+	while (error.empty() && Is("&"))
+	{
+		Next();
+		left = Boolean(AND(Truth(left), Truth(Comparison())));
+	}
+	return left;
+}
+
+ModelValues SymbolicModel::Comparison()
+{
+	ModelValues left = Sum();
+	while (error.empty() && (Is("=") || Is("!=") || Is("<") || Is("<=") || Is(">") || Is(">=")))
+	{
+		string op(*text, token.start, token.length);
+		Next();
+		left = Combine(op, left, Sum());
+	}
+	return left;
+}
+
+ModelValues SymbolicModel::Sum()
+{
+	ModelValues left = Product();
+	while (error.empty() && (Is("+") || Is("-")))
+	{
+		string op(*text, token.start, token.length);
+		Next();
+		left = Combine(op, left, Product());
+	}
+	return left;
+}
+
+ModelValues SymbolicModel::Product()
+{
+	ModelValues left = Unary();
+	while (error.empty() && (Is("*") || Is("/") || Is("mod")))
+	{
+		string op(*text, token.start, token.length);
+		Next();
+		left = Combine(op, left, Unary());
+	}
+	return left;
+}
+
+ModelValues SymbolicModel::Unary()
+{
+	if (Is("!"))
+	{
+		Next();
+		return Boolean(NOT(Truth(Unary())));
+	}
+	if (Is("-"))
+	{
+		Next();
+		return Combine("-", Constant(0), Unary());
+	}
+	return Primary();
+}
+
+ModelValues SymbolicModel::Primary()
+{
+	ModelValues ret;
+	if (token.type == MODEL_NUMBER)
+	{
+		ret = Constant(atoi(text->c_str() + token.start));
+		Next();
+		return ret;
+	}
+	if (Is("("))
+	{
+		Next();
+		ret = Implication();
+		Expect(")");
+		return ret;
+	}
+	if (Is("{")) //a choice between the values of every element
+	{
+		do
+		{
+			Next();
+			ModelValues element = Implication();
+			for (ModelValues::iterator it = element.begin(); it != element.end(); ++it) ret[it->first] = OR(ret[it->first], it->second);
+		} while (error.empty() && Is(","));
+		Expect("}");
+		return ret;
+	}
+	if (Is("case")) return Case();
+	if (token.type != MODEL_NAME)
+	{
+		Fail("expected an expression");
+		return ret;
+	}
+	string name(*text, token.start, token.length);
+	Next();
+	if (name == "TRUE" || name == "FALSE") return Constant(name == "TRUE");
+	bool next = name == "next" && Is("(");
+	if (next)
+	{
+		if (!next_allowed)
+		{
+			Fail("next() outside TRANS and next assignments");
+			return ret;
+		}
+		Next();
+		name.assign(*text, token.start, token.length);
+		if (token.type != MODEL_NAME || !variable_index.count(name))
+		{
+			Fail("expected a variable");
+			return ret;
+		}
+		Next();
+		if (!Expect(")")) return ret;
+	}
+	if (variable_index.count(name))
+	{
+		ModelVariable& variable = variables[variable_index[name]];
+		for (int i = 0; i < variable.values.size(); i++) ret[variable.values[i]] = OR(ret[variable.values[i]], next ? variable.next[i] : variable.current[i]);
+		return ret;
+	}
+	if (defines.count(name)) return defines[name];
+	if (constants.count(name)) return Constant(constants[name]);
+	Fail("unknown name " + name);
+	return ret;
+}
+
+ModelValues SymbolicModel::Case() //the first branch whose condition holds, no value where none does
+{
+	Next();
+	ModelValues ret;
+	ROBDD rest; //states no earlier condition holds in
+	rest.FromConstant(1);
+	while (error.empty() && !Is("esac"))
+	{
+		ROBDD condition = Truth(Implication());
+		if (!Expect(":")) break;
+		ModelValues values = Implication();
+		if (!Expect(";")) break;
+		ROBDD taken = AND(rest, condition);
+		for (ModelValues::iterator it = values.begin(); it != values.end(); ++it)
+		{
+			ROBDD where = AND(taken, it->second);
+			if (where.root != ROBDD_FALSE) ret[it->first] = OR(ret[it->first], where);
+		}
+		rest = AND(rest, NOT(condition));
+	}
+	if (error.empty()) Next();
+	return ret;
+}
+
+void SymbolicModel::Build() //states within the domains and invariants, on both sides of every step
+{
+	vector<int> to_next; //x_i becomes x_(depth+i)
+	for (int i = 0; i < depth; i++) to_next.push_back(depth + i);
+	states.FromConstant(1);
+	vector<ROBDD> conjuncts;
+	for (int i = 0; i < variables.size(); i++)
+	{
+		ROBDD domain;
+		for (int j = 0; j < variables[i].values.size(); j++) domain = OR(domain, variables[i].current[j]);
+		states = AND(states, domain);
+		conjuncts.push_back(AND(domain, RENAME(domain, to_next)));
+	}
+	for (int i = 0; i < invariants.size(); i++)
+	{
+		states = AND(states, invariants[i]);
+		conjuncts.push_back(AND(invariants[i], RENAME(invariants[i], to_next)));
+	}
+	conjuncts.insert(conjuncts.end(), transitions.begin(), transitions.end());
+	relation.FromConjuncts(conjuncts, depth, PartitionThreshold());
+	init = AND(init, states);
+	for (int i = 0; i < variables.size(); i++)
+	{
+		if (!variables[i].boolean) continue;
+		names.push_back(variables[i].name);
+		propositions.push_back(variables[i].current[1]);
+	}
+}
+
+string SymbolicModel::Describe(ROBDD state)
+{
+	CubeIterator cubes(state, depth);
+	if (!cubes.Next()) return "";
+	string ret;
+	for (int i = 0; i < variables.size(); i++)
+	{
+		ModelVariable& variable = variables[i];
+		int index = 0;
+		for (int k = 0; k < variable.bits; k++) index = index << 1 | (cubes.Cube()[variable.first + k] == 1 ? 1 : 0);
+		if (index >= variable.values.size()) index = 0;
+		int value = variable.values[index];
+		ret += (i == 0 ? "" : " ") + variable.name + "=";
+		if (variable.boolean) ret += value ? "TRUE" : "FALSE";
+		else if (constant_names.count(value)) ret += constant_names[value];
+		else ret += to_string(value);
+	}
+	return ret;
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include<string>
+#include<vector>
+#include<map>
+#include<unordered_map>
+#include"ROBDD.h"
+#include"Parser.h"
+using namespace std;
+//A model in a subset of SMV, compiled straight into BDDs so that no state is ever enumerated:
+//  MODULE main                               optional
+//  VAR name : boolean; name : 0..7; name : {idle, busy};
+//  DEFINE name := expr;                      DEFINEs and boolean variables are the propositions of formulas
+//  ASSIGN init(name) := expr; next(name) := expr; name := expr;
+//  INIT expr  INVAR expr  TRANS expr  FAIRNESS expr  SPEC formula  CTLSPEC formula
+//Expressions: numbers, TRUE, FALSE, names, next(name), (e), {e, e} for a choice, case c : e; ... esac,
+//! - * / mod + - = != < <= > >= & | xor <-> ->, as in SMV. Comments run from -- to the end of the line.
+//Names must be declared before they are used, VAR sections excepted. A value outside the domain of
+//a variable has no encoding, so an initial state or a step that would assign it does not exist.
+enum ModelTokenType
+{
+	MODEL_END,
+	MODEL_NAME,
+	MODEL_NUMBER,
+	MODEL_SYMBOL, //operators and punctuation, matched by their text
+	MODEL_ERROR
+};
+typedef map<int, ROBDD> ModelValues; //each value an expression can take, with the states where it does
+struct ModelVariable
+{
+	string name;
+	vector<int> values; //the domain, values[i] is encoded as i in bits first..first+bits-1, the first one most significant
+	int first, bits;
+	vector<ROBDD> current, next; //where the variable holds each value, on the state bits and on their next-state copies
+	bool boolean; //printed as TRUE and FALSE, and a proposition of formulas
+	bool assigned; //next() has been given
+};
+class SymbolicModel
+{
+public:
+	SymbolicModel();
+	bool Load(const string& path); //false if the file is missing or malformed, see Error
+	bool Parse(const string& text);
+	string Error(); //what went wrong, and where
+	int Depth() { return depth; } //state bits, their next-state copies follow them
+	TransitionRelation& Relation() { return relation; }
+	ROBDD States() { return states; } //encodings within the domains that satisfy every INVAR
+	ROBDD Init() { return init; }
+	vector<string> Names() { return names; } //of the propositions
+	vector<ROBDD>& Propositions() { return propositions; }
+	vector<ROBDD> Fairness() { return fairness; }
+	vector<string> Specs() { return specs; } //the text of each SPEC, for FormulaParser
+	string Describe(ROBDD state); //the values of the variables in a state, e.g. x=3 b=TRUE
+private:
+	const string* text;
+	int pos;
+	Token token;
+	string error;
+	int depth;
+	vector<ModelVariable> variables;
+	unordered_map<string, int> variable_index;
+	unordered_map<string, int> constants; //enumeration names, by code
+	map<int, string> constant_names;
+	unordered_map<string, ModelValues> defines;
+	bool next_allowed; //the expression being read may use next()
+	TransitionRelation relation;
+	ROBDD states, init;
+	vector<ROBDD> invariants, transitions; //INVAR and TRANS, one conjunct each
+	vector<string> names;
+	vector<ROBDD> propositions, fairness;
+	vector<string> specs;
+	void Next();
+	bool Is(const char* text); //the current token is this name or symbol
+	bool Section(); //the current token starts a section
+	bool Expect(const char* text);
+	bool Fail(const string& message);
+	void Skip(); //to the next section
+	bool Declare();
+	void Encode();
+	bool Define();
+	bool Assign();
+	ROBDD Equals(ModelVariable& variable, const ModelValues& values, bool next); //the variable takes one of the values
+	ROBDD Truth(const ModelValues& values); //where the value is not 0
+	ModelValues Implication();
+	ModelValues Equivalence();
+	ModelValues Disjunction();
+	ModelValues Conjunction();
+	ModelValues Comparison();
+	ModelValues Sum();
+	ModelValues Product();
+	ModelValues Unary();
+	ModelValues Primary();
+	ModelValues Case();
+	void Build();
+};
@@ -0,0 +1,53 @@
+#include "Trace.h"
+#include <iostream>
+#include <fstream>
+#include <memory>
+
+static int trace_level = TRACE_NONE;
+static TraceSink trace_sink;
+static const size_t TRACE_BUFFER = 1 << 16; //flushed to the sink once this many bytes are pending
+
+static ostringstream& Buffer()
+{
+	static ostringstream* buffer = new ostringstream; //never destroyed, tracing may happen during static destruction
+	return *buffer;
+}
+
+void SetTraceLevel(int level)
+{
+	trace_level = level;
+}
+
+int GetTraceLevel()
+{
+	return trace_level;
+}
+
+void SetTraceSink(TraceSink sink)
+{
+	FlushTrace();
+	trace_sink = sink;
+}
+
+bool SetTraceFile(string path)
+{
+	shared_ptr<ofstream> file(new ofstream(path.c_str(), ios::app));
+	if (!*file) return false;
+	SetTraceSink([file](const string& text) { file->write(text.data(), text.size()); file->flush(); });
+	return true;
+}
+
+ostream& TraceStream()
+{
+	if (Buffer().tellp() >= (streamoff)TRACE_BUFFER) FlushTrace();
+	return Buffer();
+}
+
+void FlushTrace()
+{
+	string text = Buffer().str();
+	if (text.empty()) return;
+	Buffer().str("");
+	if (trace_sink) trace_sink(text);
+	else cout << text << flush;
+}
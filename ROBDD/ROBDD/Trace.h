@@ -0,0 +1,19 @@
+#pragma once
+#include<string>
+#include<sstream>
+#include<functional>
+using namespace std;
+enum TraceLevel
+{
+	TRACE_NONE, //kernels stay silent
+	TRACE_STEPS, //which algorithm runs and its epochs
+	TRACE_SETS //also every intermediate set, node by node
+};
+typedef function<void(const string&)> TraceSink;
+void SetTraceLevel(int level);
+int GetTraceLevel();
+inline bool Tracing(int level) { return GetTraceLevel() >= level; }
+void SetTraceSink(TraceSink sink); //receives buffered chunks of trace text, an empty sink writes to cout
+bool SetTraceFile(string path); //appends the trace to a file, false if it cannot be opened
+ostream& TraceStream(); //buffered, only write to it after checking Tracing
+void FlushTrace(); //hands the buffer to the sink
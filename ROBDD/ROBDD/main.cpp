@@ -1,169 +1,277 @@
-﻿#include <iostream>
-#include <string>
-#include <map>
-#include "ROBDD.h"
-
-using namespace std;
-ROBDD parse(string expression);
-map<string, int> sym_to_graph;
-map<int, string> graph_to_sym;
-vector<ROBDD> robdds;
-Graph total_graph;
-int main()
-{
-	int n;
-	cout << "Input number of symbols:";
-	cin >> n;
-	cout << "Input these symbols,separated by blank:\n";
-	for (int i = 0; i < n; i++)
-	{
-		string sym;
-		cin >> sym;
-		sym_to_graph[sym] = i;
-		graph_to_sym[i] = sym;
-	}
-	int num_vert, num_edge;
-	cout << "Input total number of vertices:";
-	cin >> num_vert;
-	cout << "Input total number of edges:";
-	cin >> num_edge;
-	for (int i = 0; i < num_vert; i++)
-	{
-		total_graph.AddNode(0);
-	}
-	cout << "Input the source node and destination node of each edge respectively:" << endl;
-	for (int i = 0; i < num_edge; i++)
-	{
-		int src, dst;
-		cin >> src >> dst;
-		total_graph.AddEdge(src, dst);
-	}
-	for (int i = 0; i < n; i++)
-	{
-		cout << "Input true vertices for symbol " << graph_to_sym[i] << ", -1 indicates end" << endl;
-		int vert;
-		vector<int> table;
-		while(1)
-		{
-			cin >> vert;
-			if (vert == -1) break;
-			table.push_back(vert);
-		}
-		ROBDD robdd;
-		robdd.FromTrueValueVector(table);
-		robdds.push_back(robdd);
-	}
-	while (1)
-	{
-		cout << "Input your expression(input exit to quit):\n";
-		string expression;
-		cin >> expression;
-		if (expression == "exit") break;
-		ROBDD result = parse(expression);
-		cout << "\nResult:" << endl;
-		result.Print();
-	}
-	return 0;
-}
-ROBDD parse(string expression)
-{
-	cout << "\nComputing " << expression << "..." << endl;
-	if (!expression.empty())
-	{
-		int index = 0;
-		while ((index = expression.find(' ', index)) != string::npos)
-		{
-			expression.erase(index, 1);
-		}
-	}
-	int pos = expression.find('(', 0);
-	if (pos == string::npos)
-	{
-		return robdds[sym_to_graph[expression]];
-	}
-	string op = expression.substr(0, pos);
-	if (op == "") return parse(expression.substr(1, expression.length() - 2));
-	if (op == "and" || op == "AND")
-	{
-		string remainder = expression.substr(pos, expression.length() - pos);
-		int comma = remainder.find(',', 0);
-		string expr1 = remainder.substr(1, comma - 1);
-		string expr2 = remainder.substr(comma + 1, remainder.length() - comma - 2);
-		return AND(parse(expr1), parse(expr2));
-	}
-	else if (op == "or" || op == "OR")
-	{
-		string remainder = expression.substr(pos, expression.length() - pos);
-		int comma = remainder.find(',', 0);
-		string expr1 = remainder.substr(1, comma - 1);
-		string expr2 = remainder.substr(comma + 1, remainder.length() - comma - 2);
-		return OR(parse(expr1), parse(expr2));
-	}
-	else if (op == "imply" || op == "IMPLY")
-	{
-		string remainder = expression.substr(pos, expression.length() - pos);
-		int comma = remainder.find(',', 0);
-		string expr1 = remainder.substr(1, comma - 1);
-		string expr2 = remainder.substr(comma + 1, remainder.length() - comma - 2);
-		return IMPLY(parse(expr1), parse(expr2));
-	}
-	else if (op == "ex" || op == "EX")
-	{
-		string remainder = expression.substr(pos + 1, expression.length() - pos - 2);
-		return EX(total_graph, parse(remainder));
-	}
-	else if (op == "eg" || op == "EG")
-	{
-		string remainder = expression.substr(pos + 1, expression.length() - pos - 2);
-		return EG(total_graph, parse(remainder));
-	}
-	else if (op == "eu" || op == "EU")
-	{
-		string remainder = expression.substr(pos + 1, expression.length() - pos - 2);
-		int comma = remainder.find(',', 0);
-		string expr1 = remainder.substr(0, comma);
-		string expr2 = remainder.substr(comma + 1, remainder.length() - comma);
-		return EU(total_graph, parse(expr1), parse(expr2));
-	}
-	else if (op == "not" || op == "NOT")
-	{
-		string remainder = expression.substr(pos + 1, expression.length() - pos - 2);
-		return NOT(parse(remainder));
-	}
-	else if (op == "af" || op == "AF") //AF p=~EG~p
-	{
-		string remainder = expression.substr(pos + 1, expression.length() - pos - 2);
-		cout << "AF(" << remainder << ")=NOT(EG(NOT(" << remainder << ")))" << endl;
-		return NOT(EG(total_graph,NOT(parse(remainder))));
-	}
-	else if (op == "ax" || op == "AX") //AX p=~EX~p
-	{
-		string remainder = expression.substr(pos + 1, expression.length() - pos - 2);
-		cout << "AX(" << remainder << ")=NOT(EX(NOT" << remainder << ")))" << endl;
-		return NOT(EX(total_graph, NOT(parse(remainder))));
-	}
-	else if (op == "ef" || op == "EF") //EF ϕ ≡ E[⊤ U ϕ]
-	{
-		ROBDD robdd_true;
-		ROBDDNode* NewNode = new ROBDDNode;
-		NewNode->label = -1;
-		NewNode->value.value = 0;
-		robdd_true.nodes.push_back(NewNode);
-		robdd_true.root = NewNode;
-		string remainder = expression.substr(pos + 1, expression.length() - pos - 2);
-		cout << "EF(" << remainder << ")=E(⊤ U " << remainder << ")" << endl;
-		return EU(total_graph, robdd_true, parse(remainder));
-	}
-	else if (op == "ag" || op == "AG") //AG ϕ ≡ ~E[⊤ U ~ϕ]
-	{
-		ROBDD robdd_true;
-		ROBDDNode* NewNode = new ROBDDNode;
-		NewNode->label = -1;
-		NewNode->value.value = 0;
-		robdd_true.nodes.push_back(NewNode);
-		robdd_true.root = NewNode;
-		string remainder = expression.substr(pos + 1, expression.length() - pos - 2);
-		cout << "AG(" << remainder << ")=NOT(E(⊤ U NOT(" << remainder << ")))" << endl;
-		return NOT(EU(total_graph, robdd_true, NOT(parse(remainder))));
-	}
-}
\ No newline at end of file
+﻿#include <iostream>
+#include <string>
+#include <map>
+#include "ROBDD.h"
+#include "Trace.h"
+#include "Parallel.h"
+#include "Benchmark.h"
+#include "Formula.h"
+#include "Parser.h"
+#include "ModelFile.h"
+#include "SymbolicModel.h"
+#include "Stats.h"
+#include <fstream>
+
+using namespace std;
+int parse(string expression); //-1 on a syntax error
+void explain(FormulaChecker& checker, int formula, ROBDD start);
+unordered_map<string, int> sym_to_graph;
+map<int, string> graph_to_sym;
+vector<ROBDD> robdds;
+Graph total_graph;
+SymbolicModel model;
+bool modelled = false; //the model came from --smv, there is no graph
+FormulaDAG dag; //every formula read so far, results are kept per node
+int main(int argc, char* argv[])
+{
+	string batch; //file of formulas, one per line
+	string load, save, save_results; //model files
+	string smv; //a model in the SMV subset of SymbolicModel.h
+	int engine = ENGINE_SYMBOLIC;
+	vector<string> fair_names; //propositions every path must visit infinitely often
+	int witness = -1; //node budget of the onion rings, -1 prints no witnesses
+	string stats; //where the statistics go on exit, - for the console
+	bool reorder = true; //sift when the BDDs grow large
+	for (int i = 1; i + 1 < argc; i += 2) //--trace <level>, --trace-file <path>, --threads <count>, --cutoff <depth>, --batch <path>, --load <path>, --smv <path>, --save <path>, --save-results <path>, --engine symbolic|explicit, --fair <symbol>, --witness <ring nodes, 0 to recompute them>, --stats <JSON path, - for the console>, --reorder on|off
+	{
+		string option = argv[i];
+		if (option == "--batch") batch = argv[i + 1];
+		if (option == "--load") load = argv[i + 1];
+		if (option == "--smv") smv = argv[i + 1];
+		if (option == "--save") save = argv[i + 1];
+		if (option == "--save-results") save_results = argv[i + 1];
+		if (option == "--fair") fair_names.push_back(argv[i + 1]);
+		if (option == "--witness") witness = atoi(argv[i + 1]);
+		if (option == "--stats") stats = argv[i + 1];
+		if (option == "--reorder") reorder = string(argv[i + 1]) != "off";
+		if (option == "--engine") engine = string(argv[i + 1]) == "explicit" ? ENGINE_EXPLICIT : ENGINE_SYMBOLIC;
+		if (option == "--trace") SetTraceLevel(atoi(argv[i + 1]));
+		else if (option == "--trace-file" && !SetTraceFile(argv[i + 1])) cerr << "Cannot open " << argv[i + 1] << endl;
+		else if (option == "--threads") SetWorkers(atoi(argv[i + 1]));
+		else if (option == "--cutoff") SetSpawnCutoff(atoi(argv[i + 1]));
+		else if (option == "--bench-threads" && i + 2 < argc) //--bench-threads <nodes> <max threads>
+		{
+			BenchmarkThreads(atoi(argv[i + 1]), atoi(argv[i + 2]), cout);
+			return 0;
+		}
+		else if (option == "--bench-engines") //--bench-engines <nodes>
+		{
+			BenchmarkEngines(atoi(argv[i + 1]), cout);
+			return 0;
+		}
+		else if (option == "--bench-reorder") //--bench-reorder <counter bits>
+		{
+			BenchmarkReorder(atoi(argv[i + 1]), cout);
+			return 0;
+		}
+		else if (option == "--bench-suite" && i + 2 < argc) //--bench-suite <scale> <JSON path, - for the console>
+		{
+			if (string(argv[i + 2]) == "-")
+			{
+				BenchmarkSuite(atoi(argv[i + 1]), cout);
+				return 0;
+			}
+			ofstream json(argv[i + 2]);
+			if (!json)
+			{
+				cerr << "Cannot write " << argv[i + 2] << endl;
+				return 1;
+			}
+			BenchmarkSuite(atoi(argv[i + 1]), json);
+			return 0;
+		}
+	}
+	Manager().SetAutoReorder(reorder);
+	if (!smv.empty()) //propositions and relation compiled from the model, without any graph
+	{
+		if (!model.Load(smv))
+		{
+			cerr << "Cannot load " << smv << ": " << model.Error() << endl;
+			return 1;
+		}
+		vector<string> names = model.Names();
+		for (int i = 0; i < names.size(); i++)
+		{
+			sym_to_graph[names[i]] = i;
+			graph_to_sym[i] = names[i];
+		}
+		robdds = model.Propositions();
+		modelled = true;
+	}
+	else if (!load.empty()) //symbols, graph and labels straight from the mapped file
+	{
+		ModelFile file;
+		if (!file.Open(load))
+		{
+			cerr << "Cannot load " << load << ": " << file.Error() << endl;
+			return 1;
+		}
+		vector<string> names = file.Names();
+		for (int i = 0; i < names.size(); i++)
+		{
+			sym_to_graph[names[i]] = i;
+			graph_to_sym[i] = names[i];
+		}
+		file.LoadGraph(total_graph);
+		robdds = file.Roots();
+	}
+	else
+	{
+		int n;
+		cout << "Input number of symbols:";
+		cin >> n;
+		cout << "Input these symbols,separated by blank:\n";
+		for (int i = 0; i < n; i++)
+		{
+			string sym;
+			cin >> sym;
+			sym_to_graph[sym] = i;
+			graph_to_sym[i] = sym;
+		}
+		int num_vert, num_edge;
+		cout << "Input total number of vertices:";
+		cin >> num_vert;
+		cout << "Input total number of edges:";
+		cin >> num_edge;
+		for (int i = 0; i < num_vert; i++)
+		{
+			total_graph.AddNode(0);
+		}
+		cout << "Input the source node and destination node of each edge respectively:" << endl;
+		vector<int> sources(num_edge), targets(num_edge);
+		for (int i = 0; i < num_edge; i++)
+		{
+			cin >> sources[i] >> targets[i];
+		}
+		if (!total_graph.SetEdges(sources, targets)) //one pass over all edges
+		{
+			cerr << "Edges must join vertices 0.." << num_vert - 1 << endl;
+			return 1;
+		}
+		for (int i = 0; i < n; i++)
+		{
+			cout << "Input true vertices for symbol " << graph_to_sym[i] << ", -1 indicates end" << endl;
+			int vert;
+			vector<int> table;
+			while(1)
+			{
+				cin >> vert;
+				if (vert == -1) break;
+				table.push_back(vert);
+			}
+			ROBDD robdd;
+			robdd.FromTrueValueVector(table, total_graph.Depth());
+			robdds.push_back(robdd);
+		}
+	}
+	if (!modelled) InterleaveOrder(total_graph.Depth()); //SymbolicModel lays out its own variables
+	if (!save.empty())
+	{
+		vector<string> names;
+		for (int i = 0; i < robdds.size(); i++) names.push_back(graph_to_sym[i]);
+		if (!SaveModel(save, &total_graph, names, robdds)) cerr << "Cannot write " << save << endl;
+	}
+	FormulaChecker checker = modelled ? FormulaChecker(dag, model.Relation(), robdds) : FormulaChecker(dag, total_graph, robdds);
+	if (engine == ENGINE_EXPLICIT) total_graph.IndexPredecessors(); //for the backward searches of EG and EU
+	checker.SetEngine(engine);
+	vector<ROBDD> fairness;
+	for (int i = 0; i < fair_names.size(); i++)
+	{
+		if (sym_to_graph.count(fair_names[i]) == 0) cerr << "Unknown fairness symbol " << fair_names[i] << endl;
+		else fairness.push_back(robdds[sym_to_graph[fair_names[i]]]);
+	}
+	vector<ROBDD> model_fairness = model.Fairness();
+	fairness.insert(fairness.end(), model_fairness.begin(), model_fairness.end());
+	checker.SetFairness(fairness);
+	if (witness > 0) checker.SetWitnessBudget(witness);
+	ROBDD states; //where witnesses may start
+	if (modelled) states = model.States();
+	else states.FromRange(0, total_graph.num_nodes - 1, total_graph.Depth());
+	vector<string> specs = model.Specs();
+	for (int i = 0; i < specs.size(); i++) //a specification holds when every initial state satisfies it, as in SMV
+	{
+		int formula = parse(specs[i]);
+		if (formula == -1) continue;
+		bool holds = IMPLY(model.Init(), checker.Check(formula)).root == ROBDD_TRUE;
+		cout << "-- specification " << specs[i] << " is " << (holds ? "true" : "false") << endl;
+		if (!holds && witness >= 0 && dag.nodes[formula].op == F_NOT) explain(checker, formula, model.Init());
+	}
+	if (!batch.empty())
+	{
+		ifstream file(batch.c_str());
+		if (!file) cerr << "Cannot open " << batch << endl;
+		vector<string> expressions;
+		vector<int> formulas;
+		string expression;
+		while (getline(file, expression))
+		{
+			if (expression.find_first_not_of(" \t\r") == string::npos || expression[0] == '#') continue;
+			int formula = parse(expression);
+			if (formula == -1) continue;
+			expressions.push_back(expression);
+			formulas.push_back(formula);
+		}
+		vector<ROBDD> results = checker.Check(formulas); //shared subformulas are evaluated once
+		for (int i = 0; i < results.size(); i++)
+		{
+			cout << "\nResult of " << expressions[i] << ":" << endl;
+			results[i].Print();
+			if (witness >= 0) explain(checker, formulas[i], states);
+		}
+		if (!save_results.empty() && !SaveModel(save_results, NULL, expressions, results)) cerr << "Cannot write " << save_results << endl;
+	}
+	else while (1)
+	{
+		cout << "Input your expression(input exit to quit):\n";
+		string expression;
+		do
+		{
+			if (!getline(cin, expression)) expression = "exit";
+		} while (expression.find_first_not_of(" \t\r") == string::npos);
+		if (expression == "exit") break;
+		int formula = parse(expression);
+		if (formula == -1) continue;
+		ROBDD result = checker.Check(formula);
+		cout << "\nResult:" << endl;
+		result.Print();
+		if (witness >= 0) explain(checker, formula, states);
+	}
+	cout << "Peak live nodes: " << Manager().PeakNodes() << ", nodes allocated: " << Manager().NodesAllocated() << ", nodes freed: " << Manager().NodesFreed() << ", garbage collections: " << Manager().GCRuns() << endl;
+	cout << "Arena: " << Manager().ArenaBytes() / 1024 << " KB, peak RSS: " << PeakRSS() / 1024 << " KB" << endl;
+	cout << "Reorderings: " << Manager().ReorderRuns() << ", reorder time: " << Manager().ReorderSeconds() * 1000 << " ms, live nodes before/after the last one: " << Manager().NodesBeforeReorder() << "/" << Manager().NodesAfterReorder() << endl;
+	if (stats == "-") DumpStats(cout);
+	else if (!stats.empty())
+	{
+		ofstream json(stats.c_str());
+		if (json) DumpStats(json);
+		else cerr << "Cannot write " << stats << endl;
+	}
+	return 0;
+}
+void explain(FormulaChecker& checker, int formula, ROBDD start) //a path from some state of start, a witness if it satisfies the formula, a counterexample if not
+{
+	int op = dag.nodes[formula].op == F_NOT ? dag.nodes[dag.nodes[formula].left].op : dag.nodes[formula].op;
+	if (op != F_EX && op != F_EU && op != F_EG) return;
+	vector<ROBDD> path = checker.Witness(formula, start);
+	if (path.empty()) return;
+	cout << (dag.nodes[formula].op == F_NOT ? "Counterexample:" : "Witness:");
+	for (int i = 0; i < path.size(); i++)
+	{
+		cout << (i == 0 ? " " : " -> ");
+		if (modelled) cout << "(" << model.Describe(path[i]) << ")";
+		else
+		{
+			unsigned long long vertex = 0;
+			StateIterator(path[i], total_graph.Depth()).Next(vertex);
+			cout << vertex;
+		}
+	}
+	cout << (op == F_EG ? " (loops back)" : "") << endl;
+}
+int parse(string expression)
+{
+	FormulaParser parser(dag, sym_to_graph);
+	int formula = parser.Parse(expression);
+	if (formula == -1) cout << "Syntax error in " << expression << ": " << parser.Error() << endl;
+	return formula;
+}